@@ -29,10 +29,17 @@ SOURCES += \
         chartexamples/mainwindow.cpp \
         src/barchart.cpp \
         src/candlestickchart.cpp \
+        src/csvloader.cpp \
         src/legendwidget.cpp \
         src/linechart.cpp \
         src/chart.cpp \
         src/piechart.cpp \
+        src/seriesfile.cpp \
+        src/seriesmodel.cpp \
+        src/candleaggregator.cpp \
+        src/rangeindex.cpp \
+        src/annotationlayer.cpp \
+        src/chartgroup.cpp \
         src/stringutil.cpp \
         src/mousedisplay.cpp
 
@@ -40,13 +47,23 @@ HEADERS += \
         chartexamples/mainwindow.h \
         src/barchart.h \
         src/candlestickchart.h \
+        src/csvloader.h \
         src/legendwidget.h \
         src/linechart.h \
         src/chart.h \
         src/piechart.h \
         src/stringutil.h \
         src/axislabelsettings.h \
-        src/mousedisplay.h
+        src/mousedisplay.h \
+        src/seriesview.h \
+        src/seriesfile.h \
+        src/seriesmodel.h \
+        src/chunkedseries.h \
+        src/ingestor.h \
+        src/candleaggregator.h \
+        src/rangeindex.h \
+        src/annotationlayer.h \
+        src/chartgroup.h
 
 FORMS += \
         chartexamples/mainwindow.ui \
@@ -0,0 +1,294 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "annotationlayer.h"
+
+#include <QLineF>
+#include <QPainter>
+#include <QPen>
+#include <QRect>
+#include <QRectF>
+#include <QVector>
+
+#include <algorithm>
+
+namespace PssCharts {
+
+void AnnotationBox::Merge(const AnnotationBox& box)
+{
+    nTimeFirst = std::min(nTimeFirst, box.nTimeFirst);
+    nTimeLast = std::max(nTimeLast, box.nTimeLast);
+    dLow = std::min(dLow, box.dLow);
+    dHigh = std::max(dHigh, box.dHigh);
+}
+
+bool AnnotationBox::Intersects(const AnnotationBox& box) const
+{
+    return nTimeFirst <= box.nTimeLast && box.nTimeFirst <= nTimeLast && dLow <= box.dHigh && box.dLow <= dHigh;
+}
+
+AnnotationLayer::AnnotationLayer()
+{
+    m_fIndexDirty = false;
+    m_nMarkerSize = 7;
+}
+
+/**
+ * @brief AnnotationLayer::Add: Store an annotation, only one that is not older than the others keeps the index valid
+ */
+void AnnotationLayer::Add(const Annotation& annotation)
+{
+    bool fInOrder = m_vOrder.empty() || m_vAnnotations[m_vOrder.back()].box.nTimeFirst <= annotation.box.nTimeFirst;
+    m_vAnnotations.emplace_back(annotation);
+    if (!fInOrder)
+        m_fIndexDirty = true;
+    if (!m_fIndexDirty) {
+        m_vOrder.emplace_back(m_vAnnotations.size() - 1);
+        IndexAppend(m_vOrder.size() - 1, annotation.box);
+    }
+}
+
+/**
+ * @brief AnnotationLayer::IndexAppend: Grow the box of every group above position nIndex of the time order, which has to be the newest
+ */
+void AnnotationLayer::IndexAppend(size_t nIndex, const AnnotationBox& box) const
+{
+    if (m_vLevels.empty())
+        m_vLevels.emplace_back();
+
+    for (size_t nLevel = 0; nLevel < m_vLevels.size(); nLevel++) {
+        nIndex /= FANOUT;
+        std::vector<AnnotationBox>& vLevel = m_vLevels[nLevel];
+        if (nIndex == vLevel.size())
+            vLevel.emplace_back(box);
+        else
+            vLevel[nIndex].Merge(box);
+    }
+
+    //A query scans the whole top level, so it gets a level above it once it holds more than FANOUT boxes
+    if (m_vLevels.back().size() > FANOUT) {
+        std::vector<AnnotationBox> vParent;
+        const std::vector<AnnotationBox>& vTop = m_vLevels.back();
+        for (size_t i = 0; i < vTop.size(); i++) {
+            if (i % FANOUT == 0)
+                vParent.emplace_back(vTop[i]);
+            else
+                vParent.back().Merge(vTop[i]);
+        }
+        m_vLevels.emplace_back(std::move(vParent));
+    }
+}
+
+/**
+ * @brief AnnotationLayer::RebuildIndex: Sort the time order again and rebuild the hierarchy over it. The annotations themselves
+ * are not moved, so indexes handed out before stay valid.
+ */
+void AnnotationLayer::RebuildIndex() const
+{
+    m_vOrder.resize(m_vAnnotations.size());
+    for (size_t i = 0; i < m_vOrder.size(); i++)
+        m_vOrder[i] = i;
+    std::stable_sort(m_vOrder.begin(), m_vOrder.end(), [this](size_t a, size_t b) {
+        return m_vAnnotations[a].box.nTimeFirst < m_vAnnotations[b].box.nTimeFirst;
+    });
+
+    m_vLevels.clear();
+    for (size_t i = 0; i < m_vOrder.size(); i++)
+        IndexAppend(i, m_vAnnotations[m_vOrder[i]].box);
+    m_fIndexDirty = false;
+}
+
+void AnnotationLayer::QueryNode(size_t nLevel, size_t nIndex, const AnnotationBox& box, std::vector<size_t>& vIndexes) const
+{
+    if (!m_vLevels[nLevel][nIndex].Intersects(box))
+        return;
+
+    size_t nChildren = nLevel == 0 ? m_vOrder.size() : m_vLevels[nLevel - 1].size();
+    size_t nLast = std::min((nIndex + 1) * FANOUT, nChildren);
+    for (size_t i = nIndex * FANOUT; i < nLast; i++) {
+        if (nLevel > 0)
+            QueryNode(nLevel - 1, i, box, vIndexes);
+        else if (m_vAnnotations[m_vOrder[i]].box.Intersects(box))
+            vIndexes.emplace_back(m_vOrder[i]);
+    }
+}
+
+void AnnotationLayer::AddPoint(uint32_t nTime, double dValue, const QColor& color, const QString& strText)
+{
+    Annotation annotation;
+    annotation.type = AnnotationType::ANN_POINT;
+    annotation.box = AnnotationBox(nTime, nTime, dValue, dValue);
+    annotation.color = color;
+    annotation.strText = strText;
+    Add(annotation);
+}
+
+void AnnotationLayer::AddRect(uint32_t nTimeFirst, uint32_t nTimeLast, double dLow, double dHigh, const QColor& color, const QString& strText)
+{
+    Annotation annotation;
+    annotation.type = AnnotationType::ANN_RECT;
+    annotation.box = AnnotationBox(std::min(nTimeFirst, nTimeLast), std::max(nTimeFirst, nTimeLast), std::min(dLow, dHigh), std::max(dLow, dHigh));
+    annotation.color = color;
+    annotation.strText = strText;
+    Add(annotation);
+}
+
+void AnnotationLayer::AddLabel(uint32_t nTime, double dValue, const QString& strText, const QColor& color)
+{
+    Annotation annotation;
+    annotation.type = AnnotationType::ANN_LABEL;
+    annotation.box = AnnotationBox(nTime, nTime, dValue, dValue);
+    annotation.color = color;
+    annotation.strText = strText;
+    Add(annotation);
+}
+
+void AnnotationLayer::AddHorizontalLine(double dValue, const QColor& color, const QString& strText)
+{
+    Annotation annotation;
+    annotation.type = AnnotationType::ANN_HLINE;
+    annotation.box = AnnotationBox(0, UINT32_MAX, dValue, dValue);
+    annotation.color = color;
+    annotation.strText = strText;
+    m_vHorizontalLines.emplace_back(annotation);
+}
+
+void AnnotationLayer::Clear()
+{
+    m_vAnnotations.clear();
+    m_vOrder.clear();
+    m_vHorizontalLines.clear();
+    m_vLevels.clear();
+    m_vVisible.clear();
+    m_fIndexDirty = false;
+}
+
+/**
+ * @brief AnnotationLayer::Query: Indexes for At() of the annotations whose box intersects box, horizontal lines are not included
+ */
+void AnnotationLayer::Query(const AnnotationBox& box, std::vector<size_t>& vIndexes) const
+{
+    vIndexes.clear();
+    if (m_fIndexDirty)
+        RebuildIndex();
+    if (m_vLevels.empty())
+        return;
+
+    size_t nTop = m_vLevels.size() - 1;
+    for (size_t i = 0; i < m_vLevels[nTop].size(); i++)
+        QueryNode(nTop, i, box, vIndexes);
+}
+
+/**
+ * @brief AnnotationLayer::Paint: Draw the annotations inside boxVisible. Markers of the same kind and color are drawn
+ * with a single call, text is drawn after all of the markers so that it stays on top.
+ * @param fnConvert: converts a time and value into the point it is painted to
+ */
+void AnnotationLayer::Paint(QPainter& painter, const QRect& rectChart, const AnnotationBox& boxVisible,
+                            const std::function<QPointF(uint32_t, double)>& fnConvert) const
+{
+    Query(boxVisible, m_vVisible);
+    if (m_vVisible.empty() && m_vHorizontalLines.empty())
+        return;
+
+    painter.save();
+    painter.setClipRect(rectChart);
+
+    //Order by kind then color so that each run can be drawn as one batch
+    std::sort(m_vVisible.begin(), m_vVisible.end(), [this](size_t a, size_t b) {
+        const Annotation& annotationA = m_vAnnotations[a];
+        const Annotation& annotationB = m_vAnnotations[b];
+        if (annotationA.type != annotationB.type)
+            return annotationA.type < annotationB.type;
+        return annotationA.color.rgba() < annotationB.color.rgba();
+    });
+
+    QVector<QPointF> vPoints;
+    QVector<QRectF> vRects;
+    size_t nRunStart = 0;
+    for (size_t i = 1; i <= m_vVisible.size(); i++) {
+        const Annotation& annotationRun = m_vAnnotations[m_vVisible[nRunStart]];
+        if (i < m_vVisible.size()) {
+            const Annotation& annotation = m_vAnnotations[m_vVisible[i]];
+            if (annotation.type == annotationRun.type && annotation.color == annotationRun.color)
+                continue;
+        }
+
+        if (annotationRun.type == AnnotationType::ANN_POINT) {
+            vPoints.clear();
+            for (size_t j = nRunStart; j < i; j++) {
+                const AnnotationBox& box = m_vAnnotations[m_vVisible[j]].box;
+                vPoints.append(fnConvert(box.nTimeFirst, box.dHigh));
+            }
+            QPen penMarker(annotationRun.color);
+            penMarker.setWidth(m_nMarkerSize);
+            penMarker.setCapStyle(Qt::RoundCap);
+            painter.setPen(penMarker);
+            painter.drawPoints(vPoints.data(), vPoints.size());
+        } else if (annotationRun.type == AnnotationType::ANN_RECT) {
+            vRects.clear();
+            for (size_t j = nRunStart; j < i; j++) {
+                const AnnotationBox& box = m_vAnnotations[m_vVisible[j]].box;
+                QPointF pointTopLeft = fnConvert(box.nTimeFirst, box.dHigh);
+                QPointF pointBottomRight = fnConvert(box.nTimeLast, box.dLow);
+                vRects.append(QRectF(pointTopLeft, pointBottomRight));
+            }
+            QColor colorFill = annotationRun.color;
+            colorFill.setAlpha(annotationRun.color.alpha() / 4);
+            painter.setPen(annotationRun.color);
+            painter.setBrush(colorFill);
+            painter.drawRects(vRects.data(), vRects.size());
+        }
+        nRunStart = i;
+    }
+
+    //Horizontal lines cross the whole chart, so only their value decides if they are seen
+    for (const Annotation& annotation : m_vHorizontalLines) {
+        if (annotation.box.dHigh < boxVisible.dLow || annotation.box.dLow > boxVisible.dHigh)
+            continue;
+        double y = fnConvert(boxVisible.nTimeFirst, annotation.box.dHigh).y();
+        painter.setPen(annotation.color);
+        painter.drawLine(QLineF(rectChart.left(), y, rectChart.right(), y));
+        if (!annotation.strText.isEmpty())
+            painter.drawText(QPointF(rectChart.left() + 2, y - 2), annotation.strText);
+    }
+
+    //Text goes next to the point it belongs to, or inside the top left corner of a rect
+    for (size_t nIndex : m_vVisible) {
+        const Annotation& annotation = m_vAnnotations[nIndex];
+        if (annotation.strText.isEmpty())
+            continue;
+        QPointF point = fnConvert(annotation.box.nTimeFirst, annotation.box.dHigh);
+        if (annotation.type == AnnotationType::ANN_POINT)
+            point = QPointF(point.x() + m_nMarkerSize, point.y() - m_nMarkerSize);
+        else if (annotation.type == AnnotationType::ANN_RECT)
+            point = QPointF(point.x() + 2, point.y() + painter.fontMetrics().ascent() + 2);
+        painter.setPen(annotation.color);
+        painter.drawText(point, annotation.strText);
+    }
+
+    painter.restore();
+}
+
+} //namespace
@@ -0,0 +1,122 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef ANNOTATIONLAYER_H
+#define ANNOTATIONLAYER_H
+
+#include <QColor>
+#include <QPointF>
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+class QPainter;
+class QRect;
+
+namespace PssCharts {
+
+enum class AnnotationType {
+    ANN_POINT,
+    ANN_HLINE,
+    ANN_RECT,
+    ANN_LABEL
+};
+
+/**
+ * @brief AnnotationBox: Area covered in data space, from nTimeFirst to nTimeLast and dLow to dHigh inclusive
+ */
+struct AnnotationBox {
+    uint32_t nTimeFirst;
+    uint32_t nTimeLast;
+    double dLow;
+    double dHigh;
+
+    AnnotationBox() : nTimeFirst(0), nTimeLast(0), dLow(0), dHigh(0) {}
+    AnnotationBox(uint32_t nFirst, uint32_t nLast, double dMin, double dMax)
+        : nTimeFirst(nFirst), nTimeLast(nLast), dLow(dMin), dHigh(dMax) {}
+
+    void Merge(const AnnotationBox& box);
+    bool Intersects(const AnnotationBox& box) const;
+};
+
+struct Annotation {
+    AnnotationType type;
+    AnnotationBox box; //! A point or label covers a single time and value
+    QColor color;
+    QString strText;
+};
+
+/**
+ * @brief AnnotationLayer: Markers drawn over a chart, stored in a bounding box hierarchy over (time, value).
+ * Annotations are stored in the order they were added, so At() keeps returning the same one. The index orders them by
+ * their first time, level 0 holds the box of every FANOUT annotations in that order and every level
+ * above holds the box of FANOUT entries of the level below, so a paint only visits the groups that intersect the
+ * visible range. Adding an annotation newer than the others extends the hierarchy in place, anything else rebuilds it
+ * on the next query. Horizontal lines span every time and are kept apart, only their value is tested.
+ */
+class AnnotationLayer
+{
+public:
+    static const size_t FANOUT = 16;
+
+private:
+    std::vector<Annotation> m_vAnnotations; //! In the order they were added
+    mutable std::vector<size_t> m_vOrder; //! Indexes into m_vAnnotations by first time, sorted again on the next query after an out of order add
+    std::vector<Annotation> m_vHorizontalLines;
+    mutable std::vector<std::vector<AnnotationBox>> m_vLevels;
+    mutable bool m_fIndexDirty;
+    mutable std::vector<size_t> m_vVisible; //! Reused between paints
+    int m_nMarkerSize;
+
+    void Add(const Annotation& annotation);
+    void IndexAppend(size_t nIndex, const AnnotationBox& box) const;
+    void RebuildIndex() const;
+    void QueryNode(size_t nLevel, size_t nIndex, const AnnotationBox& box, std::vector<size_t>& vIndexes) const;
+
+public:
+    AnnotationLayer();
+
+    void AddPoint(uint32_t nTime, double dValue, const QColor& color, const QString& strText = QString());
+    void AddRect(uint32_t nTimeFirst, uint32_t nTimeLast, double dLow, double dHigh, const QColor& color, const QString& strText = QString());
+    void AddLabel(uint32_t nTime, double dValue, const QString& strText, const QColor& color);
+    void AddHorizontalLine(double dValue, const QColor& color, const QString& strText = QString());
+    void ClearHorizontalLines() { m_vHorizontalLines.clear(); }
+    void Clear();
+    size_t Size() const { return m_vAnnotations.size() + m_vHorizontalLines.size(); }
+    bool Empty() const { return Size() == 0; }
+    //! Annotations in the order they were added, the same indexes Query() returns
+    const Annotation& At(size_t nIndex) const { return m_vAnnotations[nIndex]; }
+    void SetMarkerSize(int nSize) { m_nMarkerSize = nSize; }
+    int MarkerSize() const { return m_nMarkerSize; }
+
+    void Query(const AnnotationBox& box, std::vector<size_t>& vIndexes) const;
+    void Paint(QPainter& painter, const QRect& rectChart, const AnnotationBox& boxVisible,
+               const std::function<QPointF(uint32_t, double)>& fnConvert) const;
+};
+
+} //namespace
+#endif // ANNOTATIONLAYER_H
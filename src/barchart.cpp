@@ -23,15 +23,20 @@ SOFTWARE.
 */
 
 #include "barchart.h"
+#include "chartgroup.h"
+#include "seriesmodel.h"
 #include "stringutil.h"
 
 #include <QDateTime>
 #include <QLineF>
+#include <QMouseEvent>
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPen>
 #include <QPainterPath>
 
+#include <cmath>
+
 /* ----------------------------------------------- |
  * |              TOP TITLE AREA                   |
  * |             ______________________________    |
@@ -66,6 +71,13 @@ BarChart::BarChart(QWidget *parent) : Chart (ChartType::BAR, parent)
     m_nBarWidth = 8;
     m_nBarMaxWidth = 20;
     m_nBarMinWidth = 1;
+    m_fExternalData = false;
+    m_fModelVolume = false;
+    m_aggregate = BarAggregate::BAR_NONE;
+    m_pairAggregateTime = {0, std::numeric_limits<uint32_t>::max()};
+    m_fBarIndexDirty = true;
+    m_nBarViewIndexed = 0;
+    m_nHoverBar = -1;
 
     m_fEnableFill = true;
     m_fEnableOutline = true;
@@ -114,9 +126,23 @@ QPointF BarChart::ConvertToPlotPoint(const std::pair<uint32_t, double> &pair)
         m_nBars++;
     }
 
+    return QPointF(nValueX, ConvertToPlotY(pair.second));
+}
+
+/**
+ * @brief BarChart::ConvertToPlotY: convert a bar value into the y coordinate of the top of the bar
+ */
+double BarChart::ConvertToPlotY(double dValue) const
+{
+    QRect rectChart = ChartArea();
+    if (m_yPadding > 0) {
+        rectChart.setBottom(rectChart.bottom() - m_yPadding);
+        rectChart.setTop(rectChart.top() + m_yPadding);
+    }
+
     //compute point-value of Y
     int nHeight = rectChart.height();
-    uint64_t y1 = pair.second * m_precision; //Convert to precision/uint64_t to force a certain decimal precision
+    uint64_t y1 = dValue * m_precision; //Convert to precision/uint64_t to force a certain decimal precision
     uint64_t nMaxY = MaxY()*m_precision;
     uint64_t nMinY = MinY()*m_precision;
     uint64_t nSpanY = (nMaxY - nMinY);
@@ -129,7 +155,7 @@ QPointF BarChart::ConvertToPlotPoint(const std::pair<uint32_t, double> &pair)
         dValueY /= nSpanY;
         dValueY = rectChart.bottom() - dValueY; // Qt uses inverted Y axis
     }
-    return QPointF(nValueX, dValueY);
+    return dValueY;
 }
 
 /**
@@ -155,47 +181,396 @@ std::pair<uint32_t, double> BarChart::ConvertFromPlotPoint(const QPointF& point)
     return pairValues;
 }
 
-void BarChart::SetDataPoints(std::map<uint32_t, double>& mapPoints)
+void BarChart::SetDataPoints(const std::map<uint32_t, double>& mapPoints)
+{
+    SetDataPoints(std::map<uint32_t, double>(mapPoints));
+}
+
+/**
+ * @brief BarChart::SetDataPoints Set the bars, taking ownership of the map without copying it
+ * @param mapPoints
+ */
+void BarChart::SetDataPoints(std::map<uint32_t, double>&& mapPoints)
+{
+    ReleaseModel();
+    m_mapPoints = std::move(mapPoints);
+    m_view = LineView();
+    m_fExternalData = false;
+    m_fBarIndexDirty = true;
+    DataChanged();
+}
+
+/**
+ * @brief BarChart::SetDataView Draw the bars straight from caller owned arrays instead of copying them into the chart.
+ * The caller must keep the memory alive until the chart is given new data.
+ * @param view : Bars with strictly increasing x values
+ */
+void BarChart::SetDataView(const LineView& view)
+{
+    ReleaseModel();
+    std::map<uint32_t, double>().swap(m_mapPoints);
+    m_view = view;
+    m_fExternalData = true;
+    m_fBarIndexDirty = true;
+    DataChanged();
+}
+
+/**
+ * @brief BarChart::DataViewAppended Tell the chart that bars were appended to the arrays behind its view.
+ * Only the newest bars that fit in the chart area are scanned for the extents, and in aggregated mode only the appended
+ * bars are added to the index.
+ * @param view : The grown view, which may point at a reallocated buffer
+ */
+void BarChart::DataViewAppended(const LineView& view)
+{
+    if (!m_fExternalData)
+        return;
+    if (view.Size() < m_nBarViewIndexed)
+        m_fBarIndexDirty = true;
+    m_view = view;
+    DataChanged();
+}
+
+/**
+ * @brief BarChart::SetModel Draw the bars from a shared SeriesModel, for example the volume of an instrument that is also
+ * shown in a line or candlestick chart. The chart keeps a reference to the model and repaints when it changes.
+ * @param model
+ * @param fVolume: Draw the model's volume instead of its points
+ */
+void BarChart::SetModel(const std::shared_ptr<SeriesModel>& model, bool fVolume)
+{
+    if (!model)
+        return;
+    ReleaseModel();
+    std::map<uint32_t, double>().swap(m_mapPoints);
+    m_view = LineView();
+    m_fExternalData = false;
+    m_pModel = model;
+    m_fModelVolume = fVolume;
+    m_indexBars.Clear();
+    connect(m_pModel.get(), &SeriesModel::pointsAppended, this, &BarChart::OnModelChanged);
+    connect(m_pModel.get(), &SeriesModel::pointsRemoved, this, &BarChart::OnModelChanged);
+    connect(m_pModel.get(), &SeriesModel::volumeChanged, this, &BarChart::OnModelChanged);
+    connect(m_pModel.get(), &SeriesModel::dataReset, this, &BarChart::OnModelChanged);
+    DataChanged();
+}
+
+void BarChart::ReleaseModel()
+{
+    if (m_pModel)
+        disconnect(m_pModel.get(), nullptr, this, nullptr);
+    m_pModel.reset();
+}
+
+/**
+ * @brief BarChart::Points The bars when they are held in a map, either by this chart or by its model
+ */
+const std::map<uint32_t, double>& BarChart::Points() const
+{
+    if (m_pModel)
+        return m_fModelVolume ? m_pModel->Volume() : m_pModel->Points();
+    return m_mapPoints;
+}
+
+/**
+ * @brief BarChart::OnModelChanged The model changed. Only the newest bars that fit in the chart area are rescanned.
+ */
+void BarChart::OnModelChanged()
 {
-    m_mapPoints = mapPoints;
-    ProcessChangedData();
+    DataChanged();
+    update();
 }
 
 void BarChart::ProcessChangedData()
 {
+    if (m_aggregate != BarAggregate::BAR_NONE) {
+        ProcessAggregatedData();
+        return;
+    }
+
     m_pairXRange = {0, 0};
     m_pairYRange = {0, 0};
+
+    //The x range shared by the group picks the bars, their extremes come from the group's visible range of the index
+    std::pair<double, double> pairLinked;
+    if (LinkedXRange(pairLinked)) {
+        m_pairXRange = pairLinked;
+        double dMin, dMax;
+        if (m_pChartGroup->VisibleMinMax(BarIndex(), dMin, dMax))
+            m_pairYRange = {std::min(0.0, dMin), std::max(0.0, dMax)};
+        m_fChangesMade = true;
+        return;
+    }
+
     bool fFirstRun = true;
     m_nBars = 0;
-    std::map<uint32_t, double>::reverse_iterator rit;
-    for (rit = m_mapPoints.rbegin(); rit != m_mapPoints.rend(); ++rit) {
+    QRect rectChart = ChartArea();
+    int nWidth = rectChart.width();
+    auto scanBar = [&](const std::pair<uint32_t, double>& pair) {
         // determine if bars are out of bounds
-        QRect rectChart = ChartArea();
-        int nWidth = rectChart.width();
         double nValueX = (2*m_nBars + 1) * m_nBarWidth + 2*m_nBarSpacing;
         if(nValueX > nWidth) {
-            break;
+            return false;
         } else {
             m_nBars++;
         }
 
         //Set min and max for x and y
-        if (fFirstRun || rit->first < m_pairXRange.first)
-            m_pairXRange.first = rit->first;
-        if (fFirstRun || rit->first > m_pairXRange.second)
-            m_pairXRange.second = rit->first;
-        if (rit->second < m_pairYRange.first)
-            m_pairYRange.first = rit->second;
-        if (rit->second > m_pairYRange.second)
-            m_pairYRange.second = rit->second;
+        if (fFirstRun || pair.first < m_pairXRange.first)
+            m_pairXRange.first = pair.first;
+        if (fFirstRun || pair.first > m_pairXRange.second)
+            m_pairXRange.second = pair.first;
+        if (pair.second < m_pairYRange.first)
+            m_pairYRange.first = pair.second;
+        if (pair.second > m_pairYRange.second)
+            m_pairYRange.second = pair.second;
         fFirstRun = false;
+        return true;
+    };
+
+    //Newest bars first, stopping once the chart area is full
+    if (m_fExternalData)
+        VisitUntil(m_view.rbegin(), m_view.rend(), scanBar);
+    else
+        VisitUntil(Points().rbegin(), Points().rend(), scanBar);
+    m_fChangesMade = true;
+}
+
+/**
+ * @brief BarChart::BarIndex Range sums and extremes of the bars, for aggregated columns and range queries. A model shares its own
+ * index. Bars appended to a view are added on their own, any other change rebuilds the index on next use.
+ */
+const SeriesIndex& BarChart::BarIndex()
+{
+    if (m_pModel)
+        return m_fModelVolume ? m_pModel->VolumeIndex() : m_pModel->PointIndex();
+
+    if (m_fBarIndexDirty) {
+        m_indexBars.Clear();
+        if (!m_fExternalData)
+            m_indexBars.Assign(m_mapPoints);
+        m_nBarViewIndexed = 0;
+        m_fBarIndexDirty = false;
+    }
+    if (m_fExternalData) {
+        //A bar with an x that is not past the previous one is left out, the bars after it are still indexed
+        for (size_t i = m_nBarViewIndexed; i < m_view.Size(); i++) {
+            std::pair<uint32_t, double> pair = m_view.At(i);
+            m_indexBars.Append(pair.first, pair.second);
+        }
+        m_nBarViewIndexed = m_view.Size();
+    }
+    return m_indexBars;
+}
+
+/**
+ * @brief BarChart::AggregateBars The aggregate value of the bars in [nFirst, nLast), which must not be empty
+ */
+double BarChart::AggregateBars(const SeriesIndex& index, size_t nFirst, size_t nLast) const
+{
+    switch (m_aggregate) {
+    case BarAggregate::BAR_MAX: {
+        double dMin, dMax;
+        index.MinMaxAt(nFirst, nLast, dMin, dMax);
+        return dMax;
+    }
+    case BarAggregate::BAR_MEAN:
+        return index.SumAt(nFirst, nLast) / (nLast - nFirst);
+    default:
+        return index.SumAt(nFirst, nLast);
     }
+}
+
+/**
+ * @brief BarChart::ProcessAggregatedData Split the bars in the aggregate time range over the pixel columns of the chart area.
+ * Each column is read from the index in constant or logarithmic time, so the cost follows the chart width and not the
+ * number of bars.
+ */
+void BarChart::ProcessAggregatedData()
+{
+    const SeriesIndex& index = BarIndex();
+    m_vColumns.clear();
+    m_pairXRange = {0, 0};
+    m_pairYRange = {0, 0};
+
+    //A linked x axis replaces the aggregate time range, every member showing the same model shares its visible index range
+    size_t nFirst, nLast;
+    std::pair<double, double> pairLinked;
+    bool fLinked = LinkedXRange(pairLinked) && m_pChartGroup->VisibleIndexes(index, nFirst, nLast);
+    if (!fLinked)
+        index.IndexRange(m_pairAggregateTime.first, m_pairAggregateTime.second, nFirst, nLast);
+    size_t nBars = nLast - nFirst;
+    size_t nColumns = std::min<size_t>(nBars, std::max(0, ChartArea().width()));
+    m_nBars = nColumns;
     m_fChangesMade = true;
+    if (nColumns == 0)
+        return;
+
+    m_pairXRange = {index.Time(nFirst), index.Time(nLast - 1)};
+    if (fLinked)
+        m_pairXRange = pairLinked;
+    m_vColumns.reserve(nColumns);
+    for (size_t i = 0; i < nColumns; i++) {
+        size_t nBegin = nFirst + i * nBars / nColumns;
+        size_t nEnd = nFirst + (i + 1) * nBars / nColumns;
+        double dValue = AggregateBars(index, nBegin, nEnd);
+        m_vColumns.emplace_back(index.Time(nEnd - 1), dValue);
+        if (dValue < m_pairYRange.first)
+            m_pairYRange.first = dValue;
+        if (dValue > m_pairYRange.second)
+            m_pairYRange.second = dValue;
+    }
+}
+
+/**
+ * @brief BarChart::UpdateCachedBars Convert the bars, or the columns in aggregated mode, to their screen rects in x order
+ */
+void BarChart::UpdateCachedBars()
+{
+    m_vBarRects.clear();
+    m_vBarData.clear();
+    m_nHoverBar = -1;
+    QRect rectChart = ChartArea();
+    m_rectCachedChart = rectChart;
+    if (m_aggregate != BarAggregate::BAR_NONE) {
+        //Columns share the chart width
+        double dColumnWidth = static_cast<double>(rectChart.width()) / std::max<size_t>(1, m_vColumns.size());
+        for (size_t i = 0; i < m_vColumns.size(); i++) {
+            double dLeft = rectChart.left() + i*dColumnWidth;
+            m_vBarRects.emplace_back(QPointF(dLeft, ConvertToPlotY(m_vColumns[i].second)), QPointF(dLeft + dColumnWidth, rectChart.bottom()));
+            m_vBarData.emplace_back(m_vColumns[i]);
+        }
+        return;
+    }
+
+    auto cacheBar = [&](const std::pair<uint32_t, double>& pair) {
+        QPointF chartBar = ConvertToPlotPoint(pair);
+        if (chartBar.x() == std::numeric_limits<double>::max())
+            return;
+        m_vBarRects.emplace_back(QPointF(chartBar.x() - m_nBarWidth, chartBar.y()), QPointF(chartBar.x() + m_nBarWidth, rectChart.bottom()));
+        m_vBarData.emplace_back(pair);
+    };
+
+    //With a shared x range only the bars inside it are converted
+    std::pair<double, double> pairLinked;
+    bool fLinked = LinkedXRange(pairLinked);
+    if (m_fExternalData) {
+        size_t nFirst = 0;
+        size_t nLast = m_view.Size();
+        if (fLinked)
+            m_pChartGroup->VisibleIndexes(BarIndex(), nFirst, nLast);
+        std::for_each(m_view.begin() + nFirst, m_view.begin() + nLast, cacheBar);
+    } else if (fLinked) {
+        uint32_t nStart, nEnd;
+        m_pChartGroup->XRangeTimes(nStart, nEnd);
+        std::for_each(Points().lower_bound(nStart), Points().upper_bound(nEnd), cacheBar);
+    } else {
+        std::for_each(Points().begin(), Points().end(), cacheBar);
+    }
+}
+
+/**
+ * @brief BarChart::BarIndexAt Index of the cached bar under a screen x, found by binary search since the bars are in x order
+ * @return -1 if there is no bar under x
+ */
+int BarChart::BarIndexAt(int x) const
+{
+    auto it = std::lower_bound(m_vBarRects.begin(), m_vBarRects.end(), x,
+                               [](const QRectF& rect, int x) { return rect.right() < x; });
+    if (it == m_vBarRects.end() || it->left() > x)
+        return -1;
+    return static_cast<int>(it - m_vBarRects.begin());
+}
+
+/**
+ * @brief BarChart::BarAt The bar under a point of the chart area, or in aggregated mode the time of the last bar in the column
+ * and its aggregate value. Uses the screen geometry of the last paint.
+ * @return false if there is no bar under the point
+ */
+bool BarChart::BarAt(const QPoint& point, std::pair<uint32_t, double>& bar) const
+{
+    if (!ChartArea().contains(point))
+        return false;
+    int nBar = BarIndexAt(point.x());
+    if (nBar < 0)
+        return false;
+    bar = m_vBarData[nBar];
+    return true;
+}
+
+/**
+ * @brief BarChart::BarRepaintRect The area a cached bar covers, including its outline
+ */
+QRect BarChart::BarRepaintRect(int nBar) const
+{
+    if (nBar < 0 || static_cast<size_t>(nBar) >= m_vBarRects.size())
+        return QRect();
+    return m_vBarRects[nBar].toAlignedRect().adjusted(-m_lineWidth, -m_lineWidth, m_lineWidth, m_lineWidth);
+}
+
+/**
+ * @brief BarChart::TooltipLabel The (x, y) text of the mouse display tooltip for a bar
+ */
+QString BarChart::TooltipLabel(const std::pair<uint32_t, double>& bar) const
+{
+    QString strLabel = "(";
+    if (m_settingsXLabels.labeltype == AxisLabelType::AX_TIMESTAMP) {
+        strLabel += TimeStampToString(bar.first);
+    } else {
+        strLabel += PrecisionToString(bar.first, m_settingsXLabels.Precision());
+    }
+    strLabel += ", ";
+    strLabel += PrecisionToString(bar.second, m_settingsYLabels.Precision());
+    strLabel += ")";
+    return strLabel;
+}
+
+/**
+ * @brief BarChart::TooltipRect Where the mouse display tooltip of a cached bar is drawn
+ */
+QRect BarChart::TooltipRect(int nBar) const
+{
+    if (nBar < 0 || static_cast<size_t>(nBar) >= m_vBarRects.size())
+        return QRect();
+    const QRectF& rectBar = m_vBarRects[nBar];
+    return MouseOverTooltipRect(font(), rect(), QPointF(rectBar.center().x(), rectBar.top()), TooltipLabel(m_vBarData[nBar]));
+}
+
+/**
+ * @brief BarChart::ConvertToPlotX: screen x of the center of the bar at dX
+ */
+double BarChart::ConvertToPlotX(double dX) const
+{
+    if (m_aggregate != BarAggregate::BAR_NONE)
+        return Chart::ConvertToPlotX(dX);
+    return Chart::ConvertToPlotX(dX) - m_nBarWidth;
+}
+
+double BarChart::ConvertFromPlotX(double x) const
+{
+    if (m_aggregate != BarAggregate::BAR_NONE)
+        return Chart::ConvertFromPlotX(x);
+    return Chart::ConvertFromPlotX(x + m_nBarWidth);
+}
+
+/**
+ * @brief BarChart::LinkedHoverRegion: The crosshair at dX with the bar under it and its tooltip
+ */
+QRegion BarChart::LinkedHoverRegion(double dX)
+{
+    //The cached bars are out of date, the next paint rebuilds them
+    if (m_fChangesMade || ChartArea() != m_rectCachedChart)
+        return QRegion(rect());
+
+    QRegion region = Chart::LinkedHoverRegion(dX);
+    int nBar = BarIndexAt(static_cast<int>(std::round(ConvertToPlotX(dX))));
+    region += BarRepaintRect(nBar);
+    region += TooltipRect(nBar);
+    return region;
 }
 
 void BarChart::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
 
     //Fill in the background first
     QPainter painter(this);
@@ -204,7 +579,7 @@ void BarChart::paintEvent(QPaintEvent *event)
     painter.fillRect(rect(), m_brushBackground);
 
     //If there is only one data point, then return without drawing anything but the background
-    if (m_mapPoints.size() <= 1) {
+    if (PointCount() <= 1) {
         return;
     }
 
@@ -256,6 +631,12 @@ void BarChart::paintEvent(QPaintEvent *event)
         }
      }
 
+    //The mouse is over another chart of the group, show the bar at the same x
+    QPoint pointLinked;
+    bool fLinkedHover = !fMouseInChartArea && LinkedHoverPoint(pointLinked);
+    if (fLinkedHover)
+        lposMouse = pointLinked;
+
     //Draw Bars
     QPen penBar;
     penBar.setBrush(m_brushLine);
@@ -264,15 +645,24 @@ void BarChart::paintEvent(QPaintEvent *event)
     penHighlight.setBrush(m_brushLineHighlight);
     penHighlight.setWidth(m_lineWidth);
     bool fMouseSet = false;
-    ProcessChangedData();
-    for (const std::pair<const uint32_t, double>& pair : m_mapPoints) {
-        QPointF chartBar = ConvertToPlotPoint(pair);
-        QPointF pointBar = QPointF(chartBar.x() + m_nBarWidth, chartBar.y());
-        QPointF pointOrigin = QPointF(chartBar.x() - m_nBarWidth, rectChart.bottom());
-        QRectF rect(pointBar, pointOrigin);
+
+    //The bar geometry depends on the chart area and settings, hover alone only changes which bar is highlighted
+    if (m_fChangesMade || rectChart != m_rectCachedChart) {
+        ProcessChangedData();
+        UpdateCachedBars();
+    }
+    m_nHoverBar = BarIndexAt(lposMouse.x());
+    m_mousedisplay.ClearDots();
+    if (m_nHoverBar >= 0) {
+        const QRectF& rectHover = m_vBarRects[m_nHoverBar];
+        m_mousedisplay.AddDot(QPointF(rectHover.center().x(), rectHover.top()), m_color);
+    }
+
+    //Columns narrower than their outline only get filled
+    bool fOutline = m_aggregate == BarAggregate::BAR_NONE || m_vBarRects.empty() || m_vBarRects.front().width() > 2*m_lineWidth;
+    auto paintBar = [&](const QRectF& rect, bool fHover) {
         QBrush rectBrush = m_color;
-        if (lposMouse.x() >= rect.x() - 2*m_nBarWidth && lposMouse.x() <= rect.x()) {
-            m_mousedisplay.AddDot(QPointF(chartBar.x(), chartBar.y()), m_color);
+        if (fHover) {
             if(m_fEnableHighlightBar) {
                 rectBrush = m_highlight;
             }
@@ -282,7 +672,7 @@ void BarChart::paintEvent(QPaintEvent *event)
         } else {
             painter.setPen(penBar);
         }
-        if(m_fEnableOutline) {
+        if(m_fEnableOutline && fOutline) {
             painter.drawRect(rect);
             if (m_fEnableFill) {
                 painter.fillRect(rect, rectBrush);
@@ -292,6 +682,13 @@ void BarChart::paintEvent(QPaintEvent *event)
             painter.drawRect(rect);
             painter.fillRect(rect, rectBrush);
         }
+    };
+    bool fFullPaint = event->region().contains(rectChart);
+    for (size_t i = 0; i < m_vBarRects.size(); i++) {
+        //Partial repaint, usually a hover change, so only the bars inside the dirty area are drawn
+        if (!fFullPaint && !event->region().intersects(BarRepaintRect(i)))
+            continue;
+        paintBar(m_vBarRects[i], static_cast<int>(i) == m_nHoverBar);
     }
     painter.save();
     painter.restore();
@@ -337,7 +734,7 @@ void BarChart::paintEvent(QPaintEvent *event)
             DrawXLabels(painter, vXPoints, /*drawIndicatorLine*/true);
 
             // Give detail about where mouse is located
-            if (m_mousedisplay.IsEnabled() && fMouseInChartArea) {
+            if (m_mousedisplay.IsEnabled() && (fMouseInChartArea || fLinkedHover)) {
                 //Draw the x label
                 DrawXLabels(painter, {lposMouse.x()}, /*drawIndicatorLine*/false);
             }
@@ -386,36 +783,28 @@ void BarChart::paintEvent(QPaintEvent *event)
         painter.restore();
     }
 
-    //Draw mouse display
-    if (m_mousedisplay.IsEnabled() && fMouseInChartArea) {
+    //Draw mouse display, a linked hover only has an x so it only gets the vertical line
+    if (m_mousedisplay.IsEnabled() && (fMouseInChartArea || fLinkedHover)) {
         //Cross hair lines
         painter.setPen(m_mousedisplay.Pen());
-        QPointF posLeft(rectChart.left(), lposMouse.y());
-        QPointF posRight(rectChart.right(), lposMouse.y());
-        QLineF lineMouseX(posLeft, posRight);
-        painter.drawLine(lineMouseX);
+        if (fMouseInChartArea) {
+            QPointF posLeft(rectChart.left(), lposMouse.y());
+            QPointF posRight(rectChart.right(), lposMouse.y());
+            QLineF lineMouseX(posLeft, posRight);
+            painter.drawLine(lineMouseX);
+        }
         QPointF posTop(lposMouse.x(), rectChart.top());
         QPointF posBottom(lposMouse.x(), rectChart.bottom());
         painter.drawLine(QLineF(posTop, posBottom));
+    }
 
-        //Draw a small tooltip looking item showing the point's data (x,y)
-        MouseDot mouseDot = m_mousedisplay.GetDot(0);
-        QPointF pointCircleCenter(mouseDot.Pos());
-        auto pairData = ConvertFromPlotPoint(pointCircleCenter);
-        const uint32_t& nX = pairData.first;
-        const double& nY = pairData.second;
-        QString strLabel = "(";
-        if (m_settingsXLabels.labeltype == AxisLabelType::AX_TIMESTAMP) {
-            strLabel += TimeStampToString(nX);
-        } else {
-            strLabel += PrecisionToString(nX, m_settingsXLabels.Precision());
-        }
-        strLabel += ", ";
-        strLabel += PrecisionToString(nY, m_settingsYLabels.Precision());
-        strLabel += ")";
+    //Draw a small tooltip looking item showing the hovered bar's data (x,y)
+    if (m_mousedisplay.IsEnabled() && (fMouseInChartArea || fLinkedHover) && m_nHoverBar >= 0) {
+        painter.setFont(font());
+        QString strLabel = TooltipLabel(m_vBarData[m_nHoverBar]);
 
         //Create the background of the tooltip
-        QRect rectDraw = MouseOverTooltipRect(painter, rectFull, pointCircleCenter, strLabel);
+        QRect rectDraw = TooltipRect(m_nHoverBar);
 
         QPainterPath pathBackground;
         pathBackground.addRoundedRect(rectDraw, 5, 5);
@@ -431,15 +820,15 @@ void BarChart::paintEvent(QPaintEvent *event)
 
 /**
  * @brief LineChart::MouseOverTooltipRect Get the boundaries of the tooltip that is drawn for the mouseover data.
- * @param painter: The chart widget's painter.
+ * @param fontLabel: The font the tooltip is drawn with.
  * @param rectFull: The QRect of the entire drawing area of the chart widget.
  * @param pointCircleCenter: the center of the dot that is being drawn for the mouseover.
  * @param strLabel: the label text that is being placed in the tooltip.
  * @return QRect with the coordinates that the tooltip should be drawn in.
  */
-QRect BarChart::MouseOverTooltipRect(const QPainter& painter, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const
+QRect BarChart::MouseOverTooltipRect(const QFont& fontLabel, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const
 {
-    QFontMetrics fm(painter.font());
+    QFontMetrics fm(fontLabel);
     int nWidthText = fm.horizontalAdvance(strLabel) + 4;
 
     //Place the tooltip right above the bar its displayed on.
@@ -521,6 +910,34 @@ void BarChart::EnableHighlightBorder(bool fEnable)
     m_fEnableHighlightOutline = fEnable;
 }
 
+/**
+ * @brief BarChart::SetAggregation Show every bar in the aggregate time range instead of only the newest bars that fit. When there
+ * are more bars than pixel columns, each column shows the sum, max or mean of the bars it covers, otherwise every bar gets an
+ * equal share of the chart width. BAR_NONE goes back to drawing bars at the set bar width.
+ */
+void BarChart::SetAggregation(BarAggregate aggregate)
+{
+    m_aggregate = aggregate;
+    if (m_aggregate == BarAggregate::BAR_NONE)
+        std::vector<std::pair<uint32_t, double>>().swap(m_vColumns);
+    DataChanged();
+}
+
+/**
+ * @brief BarChart::SetAggregateTimeRange Limit aggregated mode to the bars with a time in [nStart, nEnd]. Changing the range
+ * only reads the index, so zooming costs the width of the chart and not the number of bars.
+ */
+void BarChart::SetAggregateTimeRange(uint32_t nStart, uint32_t nEnd)
+{
+    m_pairAggregateTime = {nStart, nEnd};
+    DataChanged();
+}
+
+void BarChart::ResetAggregateTimeRange()
+{
+    SetAggregateTimeRange(0, std::numeric_limits<uint32_t>::max());
+}
+
 std::vector<std::pair<QString, QColor>> BarChart::GetLegendData()
 {
     std::vector<std::pair<QString, QColor>> vLegend;
@@ -528,8 +945,51 @@ std::vector<std::pair<QString, QColor>> BarChart::GetLegendData()
     return vLegend;
 }
 
+/**
+ * @brief BarChart::mouseMoveEvent Repaint only what the mouse changed: the previously and newly highlighted bars with their
+ * tooltips, and the cross hair and axis labels when the mouse display is enabled.
+ */
+void BarChart::mouseMoveEvent(QMouseEvent *event)
+{
+    QRect rectChart = ChartArea();
+    if (m_fLinkedPanning || m_fChangesMade || rectChart != m_rectCachedChart) {
+        //Panning moves every bar, or the cached bars are out of date, the next paint rebuilds them
+        Chart::mouseMoveEvent(event);
+        return;
+    }
+
+    QPoint pos = event->pos();
+    bool fInChartArea = rectChart.contains(pos);
+    int nHoverBar = BarIndexAt(pos.x());
+    bool fTooltip = m_mousedisplay.IsEnabled();
+
+    QRegion updateRegion;
+    if (nHoverBar != m_nHoverBar || fInChartArea != m_lastMouseInChartArea) {
+        updateRegion += BarRepaintRect(m_nHoverBar);
+        updateRegion += BarRepaintRect(nHoverBar);
+        if (fTooltip) {
+            updateRegion += TooltipRect(m_nHoverBar);
+            updateRegion += TooltipRect(nHoverBar);
+        }
+    }
+
+    updateRegion += MoveCrossHair(pos, fInChartArea);
+
+    m_nHoverBar = nHoverBar;
+    if (!updateRegion.isEmpty())
+        update(updateRegion);
+    BroadcastHover(pos);
+
+    //Chart::mouseMoveEvent would repaint the whole chart
+    QWidget::mouseMoveEvent(event);
+}
+
 void BarChart::wheelEvent(QWheelEvent *event)
 {
+    if (XAxisLinked()) {
+        Chart::wheelEvent(event);
+        return;
+    }
     int dBarWidth = event->angleDelta().y()/120;
     if ((m_nBarWidth > m_nBarMinWidth && dBarWidth < 0)
             || (m_nBarWidth < m_nBarMaxWidth && dBarWidth > 0)) {
@@ -28,6 +28,8 @@ SOFTWARE.
 #include "chart.h"
 #include "axislabelsettings.h"
 #include "mousedisplay.h"
+#include "rangeindex.h"
+#include "seriesview.h"
 
 #include <QBrush>
 #include <QPen>
@@ -37,29 +39,74 @@ SOFTWARE.
 #include <QWheelEvent>
 
 #include <list>
+#include <memory>
 #include <set>
 
 class QColor;
+class QMouseEvent;
 class QPaintEvent;
 
 namespace PssCharts {
 
+class SeriesModel;
+
+enum class BarAggregate
+{
+    BAR_NONE,
+    BAR_SUM,
+    BAR_MAX,
+    BAR_MEAN
+};
+
 class BarChart : public Chart
 {
     Q_OBJECT
 
 protected:
     std::map<uint32_t, double> m_mapPoints;
+    LineView m_view; //! Caller owned bars, used instead of m_mapPoints when m_fExternalData is set
+    bool m_fExternalData;
+    std::shared_ptr<SeriesModel> m_pModel; //! Shared bars, used instead of m_mapPoints when set
+    bool m_fModelVolume; //! Draw the model's volume instead of its points
+    const std::map<uint32_t, double>& Points() const;
+    size_t PointCount() const { return m_fExternalData ? m_view.Size() : Points().size(); }
+    void ReleaseModel();
     QPointF ConvertToPlotPoint(const std::pair<uint32_t, double>& pair);
+    double ConvertToPlotY(double dValue) const;
     std::pair<uint32_t, double> ConvertFromPlotPoint(const QPointF& point) override;
 
-    QRect MouseOverTooltipRect(const QPainter& painter, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const;
+    QRect MouseOverTooltipRect(const QFont& fontLabel, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const;
     void ProcessChangedData() override;
 
+    //Aggregated mode: every pixel column of the chart area shows one value for the bars it covers
+    BarAggregate m_aggregate;
+    std::pair<uint32_t, uint32_t> m_pairAggregateTime; //! Time range shown in aggregated mode
+    SeriesIndex m_indexBars; //! Range aggregates of bars held in a map or view, a model keeps its own
+    bool m_fBarIndexDirty; //! The bars changed in a way that can not be appended to the index
+    size_t m_nBarViewIndexed; //! Rows of the view already offered to the index, rows that it rejected are skipped
+    std::vector<std::pair<uint32_t, double>> m_vColumns; //! Time of the last bar and aggregate value of each column
+    void ProcessAggregatedData();
+    double AggregateBars(const SeriesIndex& index, size_t nFirst, size_t nLast) const;
+
     uint32_t ConvertBarPlotPointTime(const QPointF& point);
 
+    //Screen geometry of the drawn bars, rebuilt when the data, settings or chart area change
+    std::vector<QRectF> m_vBarRects; //! Rect of each bar or column, in x order
+    std::vector<std::pair<uint32_t, double>> m_vBarData; //! Bar or column behind each rect
+    QRect m_rectCachedChart; //! Chart area the rects were converted for
+    int m_nHoverBar; //! Index of the highlighted bar, -1 for none
+    void UpdateCachedBars();
+    int BarIndexAt(int x) const;
+    QRect BarRepaintRect(int nBar) const;
+    QString TooltipLabel(const std::pair<uint32_t, double>& bar) const;
+    QRect TooltipRect(int nBar) const;
+    double ConvertToPlotX(double dX) const override;
+    double ConvertFromPlotX(double x) const override;
+    QRegion LinkedHoverRegion(double dX) override;
+
     void wheelEvent(QWheelEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
 
     bool m_fEnableOutline;
     bool m_fEnableFill;
@@ -81,7 +128,11 @@ protected:
 public:
     BarChart(QWidget* parent = nullptr);
 
-    void SetDataPoints(std::map<uint32_t, double>& mapPoints);
+    void SetDataPoints(const std::map<uint32_t, double>& mapPoints);
+    void SetDataPoints(std::map<uint32_t, double>&& mapPoints);
+    void SetDataView(const LineView& view);
+    void DataViewAppended(const LineView& view);
+    void SetModel(const std::shared_ptr<SeriesModel>& model, bool fVolume = false);
     void SetBarColor(const QColor& color);
     void SetLineWidth(int nWidth);
     void SetLineBrush(const QBrush& brush);
@@ -93,8 +144,17 @@ public:
     void EnableBorder(bool fEnable);
     void EnableHighlight(bool fEnable);
     void EnableHighlightBorder(bool fEnable);
+    const SeriesIndex& BarIndex();
+    bool BarAt(const QPoint& point, std::pair<uint32_t, double>& bar) const;
+    void SetAggregation(BarAggregate aggregate);
+    BarAggregate Aggregation() const { return m_aggregate; }
+    void SetAggregateTimeRange(uint32_t nStart, uint32_t nEnd);
+    void ResetAggregateTimeRange();
     std::vector<std::pair<QString, QColor>> GetLegendData();
 
+private slots:
+    void OnModelChanged();
+
 signals:
     void barWidthChanged(int dChange);
 };
@@ -0,0 +1,184 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "candleaggregator.h"
+
+#include <algorithm>
+#include <system_error>
+#include <thread>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace PssCharts {
+
+/**
+ * @brief CandleAggregator::Aggregate: Build the candles of a period from ticks, splitting the work over several threads
+ */
+std::vector<std::pair<uint32_t, Candle>> CandleAggregator::Aggregate(const uint32_t* pTime, const double* pPrice, const double* pVolume,
+                                                                     size_t nCount, uint32_t nPeriod, unsigned nThreads)
+{
+    std::vector<std::pair<uint32_t, Candle>> vCandles;
+    if (nCount == 0)
+        return vCandles;
+    nPeriod = std::max<uint32_t>(1, nPeriod);
+
+    if (nThreads == 0)
+        nThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t nParts = std::min<size_t>(nThreads, std::max<size_t>(1, nCount / MIN_TICKS_PER_THREAD));
+    if (nParts == 1) {
+        AggregateRange(pTime, pPrice, pVolume, 0, nCount, nPeriod, vCandles);
+        return vCandles;
+    }
+
+    //Move each even split back to the start of the candle it falls in, so that no candle spans two parts
+    std::vector<size_t> vSplits(1, 0);
+    for (size_t i = 1; i < nParts; i++) {
+        uint32_t nTime = pTime[nCount * i / nParts];
+        size_t nSplit = std::lower_bound(pTime, pTime + nCount, nTime - nTime % nPeriod) - pTime;
+        vSplits.emplace_back(std::max(nSplit, vSplits.back()));
+    }
+    vSplits.emplace_back(nCount);
+
+    std::vector<std::vector<std::pair<uint32_t, Candle>>> vParts(nParts);
+    std::vector<std::thread> vThreads;
+    vThreads.reserve(nParts - 1);
+
+    //Join whatever was started however this is left, destroying a joinable thread terminates the program
+    struct JoinGuard {
+        std::vector<std::thread>& vThreads;
+        ~JoinGuard()
+        {
+            for (std::thread& thread : vThreads) {
+                if (thread.joinable())
+                    thread.join();
+            }
+        }
+    } guard = {vThreads};
+
+    //Parts that no thread could be started for are done on this one
+    size_t nStarted = 1;
+    try {
+        for (; nStarted < nParts; nStarted++) {
+            vThreads.emplace_back(AggregateRange, pTime, pPrice, pVolume, vSplits[nStarted], vSplits[nStarted + 1], nPeriod,
+                                  std::ref(vParts[nStarted]));
+        }
+    } catch (const std::system_error&) {
+    }
+    AggregateRange(pTime, pPrice, pVolume, vSplits[0], vSplits[1], nPeriod, vParts[0]);
+    for (size_t i = nStarted; i < nParts; i++)
+        AggregateRange(pTime, pPrice, pVolume, vSplits[i], vSplits[i + 1], nPeriod, vParts[i]);
+    for (std::thread& thread : vThreads)
+        thread.join();
+
+    size_t nCandles = 0;
+    for (const auto& vPart : vParts)
+        nCandles += vPart.size();
+    vCandles.reserve(nCandles);
+    for (const auto& vPart : vParts)
+        vCandles.insert(vCandles.end(), vPart.begin(), vPart.end());
+    return vCandles;
+}
+
+/**
+ * @brief CandleAggregator::AggregateRange: Append the candles of the ticks in [nBegin, nEnd) to vCandles
+ */
+void CandleAggregator::AggregateRange(const uint32_t* pTime, const double* pPrice, const double* pVolume, size_t nBegin, size_t nEnd,
+                                      uint32_t nPeriod, std::vector<std::pair<uint32_t, Candle>>& vCandles)
+{
+    size_t i = nBegin;
+    while (i < nEnd) {
+        uint32_t nBucket = pTime[i] - pTime[i] % nPeriod;
+
+        //The last period may end past the largest time
+        size_t j = nEnd;
+        if (nBucket <= UINT32_MAX - nPeriod)
+            j = std::lower_bound(pTime + i, pTime + nEnd, nBucket + nPeriod) - pTime;
+
+        //Ticks are not validated, so the throwing constructor is bypassed
+        Candle candle;
+        candle.m_open = pPrice[i];
+        candle.m_close = pPrice[j - 1];
+        MinMax(pPrice + i, j - i, candle.m_low, candle.m_high);
+        candle.m_volume = pVolume ? Sum(pVolume + i, j - i) : 0;
+        vCandles.emplace_back(nBucket, candle);
+        i = j;
+    }
+}
+
+/**
+ * @brief CandleAggregator::MinMax: Smallest and largest of nCount values, nCount must not be 0
+ */
+void CandleAggregator::MinMax(const double* pValues, size_t nCount, double& dMin, double& dMax)
+{
+    size_t i = 0;
+    dMin = pValues[0];
+    dMax = pValues[0];
+#if defined(__SSE2__)
+    //Two independent pairs of accumulators, four values per iteration
+    if (nCount >= 4) {
+        __m128d vMinA = _mm_loadu_pd(pValues);
+        __m128d vMinB = _mm_loadu_pd(pValues + 2);
+        __m128d vMaxA = vMinA;
+        __m128d vMaxB = vMinB;
+        for (i = 4; i + 4 <= nCount; i += 4) {
+            __m128d vA = _mm_loadu_pd(pValues + i);
+            __m128d vB = _mm_loadu_pd(pValues + i + 2);
+            vMinA = _mm_min_pd(vMinA, vA);
+            vMinB = _mm_min_pd(vMinB, vB);
+            vMaxA = _mm_max_pd(vMaxA, vA);
+            vMaxB = _mm_max_pd(vMaxB, vB);
+        }
+        double arrMin[2];
+        double arrMax[2];
+        _mm_storeu_pd(arrMin, _mm_min_pd(vMinA, vMinB));
+        _mm_storeu_pd(arrMax, _mm_max_pd(vMaxA, vMaxB));
+        dMin = std::min(arrMin[0], arrMin[1]);
+        dMax = std::max(arrMax[0], arrMax[1]);
+    }
+#endif
+    for (; i < nCount; i++) {
+        dMin = std::min(dMin, pValues[i]);
+        dMax = std::max(dMax, pValues[i]);
+    }
+}
+
+double CandleAggregator::Sum(const double* pValues, size_t nCount)
+{
+    //Independent partial sums so that the additions do not wait on each other
+    double arrSum[4] = {0, 0, 0, 0};
+    size_t i = 0;
+    for (; i + 4 <= nCount; i += 4) {
+        arrSum[0] += pValues[i];
+        arrSum[1] += pValues[i + 1];
+        arrSum[2] += pValues[i + 2];
+        arrSum[3] += pValues[i + 3];
+    }
+    for (; i < nCount; i++)
+        arrSum[0] += pValues[i];
+    return (arrSum[0] + arrSum[1]) + (arrSum[2] + arrSum[3]);
+}
+
+} //namespace
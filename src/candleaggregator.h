@@ -0,0 +1,64 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CANDLEAGGREGATOR_H
+#define CANDLEAGGREGATOR_H
+
+#include "candlestickchart.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace PssCharts {
+
+/**
+ * @brief CandleAggregator: Builds candles from ticks held in contiguous arrays. Candles cover whole periods counted from time 0,
+ * so the arrays can be cut at candle boundaries and each part aggregated on its own thread. Each part's candles are complete,
+ * so stitching the parts is a concatenation.
+ */
+class CandleAggregator
+{
+public:
+    static const size_t MIN_TICKS_PER_THREAD = 1 << 16; //! Smaller inputs are not worth a thread
+
+    /**
+     * @param pTime: Tick times, in non-decreasing order. Several ticks may share a time.
+     * @param pPrice: Tick prices
+     * @param pVolume: Tick volumes, may be null
+     * @param nCount: Number of ticks
+     * @param nPeriod: Candle period
+     * @param nThreads: Maximum number of threads, 0 uses one per core
+     * @return Candles keyed by the start of their period, in time order
+     */
+    static std::vector<std::pair<uint32_t, Candle>> Aggregate(const uint32_t* pTime, const double* pPrice, const double* pVolume,
+                                                              size_t nCount, uint32_t nPeriod, unsigned nThreads = 0);
+    static void AggregateRange(const uint32_t* pTime, const double* pPrice, const double* pVolume, size_t nBegin, size_t nEnd,
+                               uint32_t nPeriod, std::vector<std::pair<uint32_t, Candle>>& vCandles);
+    static void MinMax(const double* pValues, size_t nCount, double& dMin, double& dMax);
+    static double Sum(const double* pValues, size_t nCount);
+};
+
+} //namespace
+#endif // CANDLEAGGREGATOR_H
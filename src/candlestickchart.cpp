@@ -23,14 +23,21 @@ SOFTWARE.
 */
 
 #include "candlestickchart.h"
+#include "candleaggregator.h"
+#include "chartgroup.h"
+#include "seriesmodel.h"
 #include "stringutil.h"
 
 #include <QDateTime>
 #include <QLineF>
+#include <QMouseEvent>
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPen>
 
+#include <cmath>
+#include <limits>
+
 /* ----------------------------------------------- |
  * |              TOP TITLE AREA                   |
  * |             ______________________________    |
@@ -68,11 +75,22 @@ CandlestickChart::CandlestickChart(QWidget *parent) : Chart (ChartType::CANDLEST
     m_nCandleMaxWidth = 20;
     m_nCandleMinWidth = 1;
     m_nCandleTimePeriod = 60;
+    m_fExternalData = false;
+    m_fTickData = false;
+    m_pairYDataRange = {0, 0};
+    m_fCandleIndexDirty = true;
+    m_nSyncedCandles = 0;
+    m_nScrollOffset = 0;
+    m_nFirstVisible = 0;
+    m_nLastVisible = 0;
+    m_fPanning = false;
+    m_nPanStartOffset = 0;
     m_fChangesMade = true;
     m_rightMargin = -1;
     m_topTitleHeight = -1;
     m_precision = 100000000;
     m_strOHLC = "O:0\tH:0\tL:0\tC:0\t0%";
+    m_fOHLCShowsNewest = false;
     m_colorUpCandle = Qt::green;
     m_colorDownCandle = Qt::red;
     m_colorUpCandleLine = Qt::darkGreen;
@@ -210,6 +228,50 @@ uint32_t CandlestickChart::ConvertCandlePlotPointTime(const QPointF& point)
     return  t2 + MinX();
 }
 
+/**
+ * @brief CandlestickChart::NearestCandle: find the candle whose period is closest to a timestamp
+ * @param nTime: timestamp, usually taken from the mouse position
+ * @param candle: set to the closest candle
+ * @return false if there are no candles
+ */
+bool CandlestickChart::NearestCandle(uint32_t nTime, Candle& candle) const
+{
+    size_t nCount = CandleCount();
+    if (nCount == 0)
+        return false;
+
+    //Compare the first candle at or after the period start with the one after it
+    uint32_t nKey = nTime - m_nCandleTimePeriod;
+    std::pair<uint32_t, Candle> pairLower;
+    std::pair<uint32_t, Candle> pairUpper;
+    if (m_fExternalData) {
+        size_t nLower = std::min(m_viewCandles.LowerBound(nKey), nCount - 1);
+        size_t nUpper = m_viewCandles.Time(nLower) == nKey ? std::min(nLower + 1, nCount - 1) : nLower;
+        pairLower = m_viewCandles.At(nLower);
+        pairUpper = m_viewCandles.At(nUpper);
+    } else if (m_pSource) {
+        size_t nLower = std::min(m_snapshotCandles.LowerBound(nKey), nCount - 1);
+        size_t nUpper = m_snapshotCandles.X(nLower) == nKey ? std::min(nLower + 1, nCount - 1) : nLower;
+        pairLower = m_snapshotCandles.At(nLower);
+        pairUpper = m_snapshotCandles.At(nUpper);
+    } else {
+        const std::map<uint32_t, Candle>& mapCandles = CandleMap();
+        std::map<uint32_t, Candle>::const_iterator itLower = mapCandles.lower_bound(nKey);
+        std::map<uint32_t, Candle>::const_iterator itUpper = mapCandles.upper_bound(nKey);
+        if (itLower == mapCandles.end())
+            itLower = std::prev(mapCandles.end());
+        if (itUpper == mapCandles.end())
+            itUpper = std::prev(mapCandles.end());
+        pairLower = *itLower;
+        pairUpper = *itUpper;
+    }
+
+    int upperDist = std::abs(static_cast<int>(pairUpper.first) - static_cast<int>(nTime));
+    int lowerDist = std::abs(static_cast<int>(pairLower.first) - static_cast<int>(nTime));
+    candle = upperDist > lowerDist ? pairLower.second : pairUpper.second;
+    return true;
+}
+
 /**
  * @brief CandlestickChart::ConvertFromPlotPoint: get the timestamp for a candle on the chart
  * @return
@@ -233,16 +295,16 @@ std::pair<uint32_t, double> CandlestickChart::ConvertFromPlotPoint(const QPointF
     return pairValues;
 }
 
-std::map<uint32_t, Candle> CandlestickChart::ConvertLineToCandlestickData(const std::map<uint32_t, double> lineChartData, uint32_t candleTimePeriod)
+std::map<uint32_t, Candle> CandlestickChart::ConvertLineToCandlestickData(const std::map<uint32_t, double>& lineChartData, uint32_t candleTimePeriod)
 {
     uint32_t startTime = 0;
     Candle currentCandle;
     std::map<uint32_t, Candle> candleData;
     bool fFirstRun = true;
-    for (const std::pair<uint32_t, double> pair : lineChartData) {
+    for (const auto& pair : lineChartData) {
         if ((pair.first - startTime) > candleTimePeriod || fFirstRun) {
             if (!fFirstRun) {
-                candleData.emplace(std::make_pair(startTime, currentCandle));
+                candleData.emplace_hint(candleData.end(), startTime, currentCandle);
             }
             startTime = pair.first;
             currentCandle.m_open = pair.second;
@@ -256,7 +318,7 @@ std::map<uint32_t, Candle> CandlestickChart::ConvertLineToCandlestickData(const
             currentCandle.m_close = pair.second;
         }
     }
-    candleData.emplace(std::make_pair(startTime, currentCandle));
+    candleData.emplace_hint(candleData.end(), startTime, currentCandle);
     return candleData;
 }
 
@@ -267,12 +329,12 @@ std::map<uint32_t, Candle> CandlestickChart::ConvertLineToCandlestickData(const
  * @param candleTimePeriod Time period used to create a candle
  * @return
  */
-std::map<uint32_t, Candle> CandlestickChart::ConvertLineToCandlestickData(const std::map<uint32_t, double> lineChartData, std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod)
+std::map<uint32_t, Candle> CandlestickChart::ConvertLineToCandlestickData(const std::map<uint32_t, double>& lineChartData, const std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod)
 {
     int volItems = 1;
     double volume = 0;
     std::map<uint32_t, Candle> candleData = ConvertLineToCandlestickData(lineChartData, candleTimePeriod);
-    std::map<uint32_t, double>::iterator it_vol = volPoints.begin();
+    std::map<uint32_t, double>::const_iterator it_vol = volPoints.begin();
     std::map<uint32_t, Candle>::iterator it_candle = candleData.begin();
     while (it_vol != volPoints.end() && it_candle != candleData.end()) {
         if(it_vol->first < it_candle->first) {
@@ -293,28 +355,523 @@ std::map<uint32_t, Candle> CandlestickChart::ConvertLineToCandlestickData(const
     return candleData;
 }
 
-void CandlestickChart::SetDataPoints(std::map<uint32_t, Candle>& mapPoints)
+void CandlestickChart::SetDataPoints(const std::map<uint32_t, Candle>& mapPoints)
+{
+    SetDataPoints(std::map<uint32_t, Candle>(mapPoints));
+}
+
+/**
+ * @brief CandlestickChart::SetDataPoints Set the candles, taking ownership of the map without copying it
+ * @param mapPoints
+ */
+void CandlestickChart::SetDataPoints(std::map<uint32_t, Candle>&& mapPoints)
+{
+    ReleaseModel();
+    m_mapPoints = std::move(mapPoints);
+    m_viewCandles = CandleView();
+    m_fExternalData = false;
+    m_pSource.reset();
+    m_snapshotCandles = ChunkedSeries<Candle>::Snapshot();
+    ReleaseTicks();
+    m_fCandleIndexDirty = true;
+    DataChanged();
+}
+
+void CandlestickChart::SetDataPoints(const std::map<uint32_t, double>& mapPoints, uint32_t candleTimePeriod)
+{
+    SetDataPoints(mapPoints, std::map<uint32_t, double>(), candleTimePeriod);
+}
+
+/**
+ * @brief CandlestickChart::SetDataPoints Set ticks that the chart builds candles from. The ticks are kept, so the candles of any
+ * period can be built when SetCandleTimePeriod() asks for them. Candles cover whole periods counted from time 0 and their volume
+ * is the sum of the tick volume inside the period. A volume point counts towards the last tick at or before its time.
+ * @param mapPoints: Price at each tick time
+ * @param volPoints: Volume traded at each tick time
+ * @param candleTimePeriod: Candle period, 0 keeps the current period
+ */
+void CandlestickChart::SetDataPoints(const std::map<uint32_t, double>& mapPoints, const std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod)
+{
+    m_vTickTime.clear();
+    m_vTickPrice.clear();
+    m_vTickTime.reserve(mapPoints.size());
+    m_vTickPrice.reserve(mapPoints.size());
+    for (const auto& pair : mapPoints) {
+        m_vTickTime.emplace_back(pair.first);
+        m_vTickPrice.emplace_back(pair.second);
+    }
+    AssignTickVolume(volPoints);
+    UseTicks(candleTimePeriod);
+}
+
+/**
+ * @brief CandlestickChart::SetTicks Set ticks held in contiguous arrays, see SetDataPoints(). The arrays are copied, and several
+ * ticks may share a time. Large tick histories are aggregated into candles on all cores.
+ * @param pTime: Tick times in non-decreasing order
+ * @param pPrice: Tick prices
+ * @param pVolume: Tick volumes, may be null
+ * @param nCount: Number of ticks
+ * @param candleTimePeriod: Candle period, 0 keeps the current period
+ */
+void CandlestickChart::SetTicks(const uint32_t* pTime, const double* pPrice, const double* pVolume, size_t nCount, uint32_t candleTimePeriod)
 {
-    m_mapPoints = mapPoints;
-    ProcessChangedData();
+    m_vTickTime.assign(pTime, pTime + nCount);
+    m_vTickPrice.assign(pPrice, pPrice + nCount);
+    if (pVolume)
+        m_vTickVolume.assign(pVolume, pVolume + nCount);
+    else
+        m_vTickVolume.assign(nCount, 0);
+    UseTicks(candleTimePeriod);
 }
 
-void CandlestickChart::SetDataPoints(std::map<uint32_t, double>& mapPoints, uint32_t candleTimePeriod)
+void CandlestickChart::UseTicks(uint32_t candleTimePeriod)
 {
     if(candleTimePeriod) {
         m_nCandleTimePeriod = candleTimePeriod;
     }
-    m_mapPoints = ConvertLineToCandlestickData(mapPoints, m_nCandleTimePeriod);
-    ProcessChangedData();
+    ReleaseModel();
+    std::map<uint32_t, Candle>().swap(m_mapPoints);
+    m_viewCandles = CandleView();
+    m_fExternalData = false;
+    m_pSource.reset();
+    m_snapshotCandles = ChunkedSeries<Candle>::Snapshot();
+    m_mapCandleCache.clear();
+    m_fTickData = true;
+    m_fCandleIndexDirty = true;
+    DataChanged();
 }
 
-void CandlestickChart::SetDataPoints(std::map<uint32_t, double>& mapPoints, std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod)
+/**
+ * @brief CandlestickChart::AssignTickVolume Give each volume point to the last tick at or before its time, or the first tick
+ */
+void CandlestickChart::AssignTickVolume(const std::map<uint32_t, double>& volPoints)
 {
-    if(candleTimePeriod) {
+    m_vTickVolume.assign(m_vTickTime.size(), 0);
+    if (m_vTickTime.empty())
+        return;
+    size_t nTick = 0;
+    for (const auto& pair : volPoints) {
+        while (nTick + 1 < m_vTickTime.size() && m_vTickTime[nTick + 1] <= pair.first)
+            nTick++;
+        m_vTickVolume[nTick] += pair.second;
+    }
+}
+
+/**
+ * @brief CandlestickChart::AddTick Add a trade to the forming candle, or open a new candle once the tick falls outside the
+ * forming candle's period. A tick that stays inside the visible price range only updates the forming candle: its screen
+ * geometry is converted again and only its area is repainted.
+ * When the chart was given ticks, the tick is kept and every cached period is updated. Otherwise candles are split the same way
+ * as ConvertLineToCandlestickData and ticks older than the forming candle are ignored.
+ * @param nTime: Time of the trade
+ * @param dPrice: Trade price
+ * @param dVolume: Traded volume, added to the candle's volume
+ */
+void CandlestickChart::AddTick(uint32_t nTime, double dPrice, double dVolume)
+{
+    //Candles read through a view, a model or a source can not be edited through the chart
+    if (!m_fTickData && !OwnsCandles())
+        return;
+
+    bool fNewCandle = false;
+    if (m_fTickData) {
+        size_t nCandlesBefore = CandleMap().size();
+        if (!AddTickToCache(nTime, dPrice, dVolume)) {
+            //Out of order, the cached candles are rebuilt when they are next used
+            DataChanged();
+            update();
+            return;
+        }
+        fNewCandle = CandleMap().size() != nCandlesBefore;
+    } else {
+        if (!m_mapPoints.empty() && nTime < m_mapPoints.rbegin()->first)
+            return;
+        if (m_mapPoints.empty() || nTime - m_mapPoints.rbegin()->first > m_nCandleTimePeriod) {
+            m_mapPoints.emplace_hint(m_mapPoints.end(), nTime, Candle(dPrice, dPrice, dPrice, dPrice, dVolume));
+            fNewCandle = true;
+        } else {
+            Candle& candle = m_mapPoints.rbegin()->second;
+            candle.m_high = std::max(candle.m_high, dPrice);
+            candle.m_low = std::min(candle.m_low, dPrice);
+            candle.m_close = dPrice;
+            candle.m_volume += dVolume;
+        }
+    }
+
+    const std::pair<const uint32_t, Candle>& pairNewest = *CandleMap().rbegin();
+    bool fIndexed = !fNewCandle && !m_fCandleIndexDirty && !InUpdate();
+    if (fIndexed)
+        m_rangeCandles.Set(m_rangeCandles.Size() - 1, pairNewest.second.m_low, pairNewest.second.m_high);
+    if (fIndexed && m_nScrollOffset > 0) {
+        //The forming candle is scrolled out of view, only the header can show it
+        if (m_fDisplayOHLC && m_fOHLCShowsNewest) {
+            QString strOHLC = OHLCString(pairNewest.second);
+            update(OHLCRect(m_strOHLC).united(OHLCRect(strOHLC)));
+            m_strOHLC = strOHLC;
+        }
+        return;
+    }
+
+    //Period rollover moves the x extents, and anything else that moves the extents or is waiting for a rescan is repainted in full
+    bool fInRange = dPrice >= m_pairYDataRange.first && dPrice <= m_pairYDataRange.second;
+    if (fNewCandle || !fInRange || InUpdate() || m_fChangesMade || m_vCachedCandles.empty() || ChartArea() != m_rectCachedChart) {
+        DataChanged();
+        update();
+        return;
+    }
+
+    //Only the forming candle moved on screen, and the header if it is showing that candle
+    std::pair<uint32_t, Candle> chartCandle = ConvertToCandlePlotPoint(pairNewest);
+    update(CandleRect(m_vCachedCandles.front()).united(CandleRect(chartCandle)));
+    m_vCachedCandles.front() = chartCandle;
+    if (m_fDisplayOHLC && m_fOHLCShowsNewest) {
+        QString strOHLC = OHLCString(pairNewest.second);
+        update(OHLCRect(m_strOHLC).united(OHLCRect(strOHLC)));
+        m_strOHLC = strOHLC;
+    }
+}
+
+/**
+ * @brief CandlestickChart::AddToBucket Merge a tick or a finer candle into the candle of a period. Input must arrive in time order.
+ * @param nBucket: Start time of the period the input falls in
+ * @return true if a new candle was opened
+ */
+bool CandlestickChart::AddToBucket(std::map<uint32_t, Candle>& mapCandles, uint32_t nBucket, const Candle& candle)
+{
+    if (mapCandles.empty() || mapCandles.rbegin()->first != nBucket) {
+        mapCandles.emplace_hint(mapCandles.end(), nBucket, candle);
+        return true;
+    }
+    Candle& candleBucket = mapCandles.rbegin()->second;
+    candleBucket.m_high = std::max(candleBucket.m_high, candle.m_high);
+    candleBucket.m_low = std::min(candleBucket.m_low, candle.m_low);
+    candleBucket.m_close = candle.m_close;
+    candleBucket.m_volume += candle.m_volume;
+    return false;
+}
+
+/**
+ * @brief CandlestickChart::CachedCandles The candles of a period, built from the retained ticks the first time they are asked for.
+ * A period that is a multiple of a cached one is built from the coarsest such period instead of the ticks.
+ */
+const std::map<uint32_t, Candle>& CandlestickChart::CachedCandles(uint32_t nPeriod) const
+{
+    nPeriod = std::max<uint32_t>(1, nPeriod);
+    auto it = m_mapCandleCache.find(nPeriod);
+    if (it != m_mapCandleCache.end())
+        return it->second;
+
+    const std::map<uint32_t, Candle>* pFiner = nullptr;
+    for (const auto& pair : m_mapCandleCache) {
+        if (pair.first < nPeriod && nPeriod % pair.first == 0)
+            pFiner = &pair.second;
+    }
+
+    std::map<uint32_t, Candle>& mapCandles = m_mapCandleCache[nPeriod];
+    if (pFiner) {
+        for (const auto& pair : *pFiner)
+            AddToBucket(mapCandles, pair.first - pair.first % nPeriod, pair.second);
+        return mapCandles;
+    }
+
+    std::vector<std::pair<uint32_t, Candle>> vCandles = CandleAggregator::Aggregate(m_vTickTime.data(), m_vTickPrice.data(),
+                                                                                     m_vTickVolume.data(), m_vTickTime.size(), nPeriod);
+    for (const auto& pair : vCandles)
+        mapCandles.emplace_hint(mapCandles.end(), pair);
+    return mapCandles;
+}
+
+/**
+ * @brief CandlestickChart::AddTickToCache Keep a tick and add it to every cached period
+ * @return false if the tick is older than the newest tick, in which case the cached candles were dropped
+ */
+bool CandlestickChart::AddTickToCache(uint32_t nTime, double dPrice, double dVolume)
+{
+    if (m_vTickTime.empty() || nTime >= m_vTickTime.back()) {
+        m_vTickTime.emplace_back(nTime);
+        m_vTickPrice.emplace_back(dPrice);
+        m_vTickVolume.emplace_back(dVolume);
+        for (auto& pair : m_mapCandleCache)
+            AddToBucket(pair.second, nTime - nTime % pair.first, Candle(dPrice, dPrice, dPrice, dPrice, dVolume));
+        return true;
+    }
+
+    size_t nPos = std::upper_bound(m_vTickTime.begin(), m_vTickTime.end(), nTime) - m_vTickTime.begin();
+    m_vTickTime.insert(m_vTickTime.begin() + nPos, nTime);
+    m_vTickPrice.insert(m_vTickPrice.begin() + nPos, dPrice);
+    m_vTickVolume.insert(m_vTickVolume.begin() + nPos, dVolume);
+    m_mapCandleCache.clear();
+    m_fCandleIndexDirty = true;
+    return false;
+}
+
+void CandlestickChart::ReleaseTicks()
+{
+    std::vector<uint32_t>().swap(m_vTickTime);
+    std::vector<double>().swap(m_vTickPrice);
+    std::vector<double>().swap(m_vTickVolume);
+    m_mapCandleCache.clear();
+    m_fTickData = false;
+}
+
+/**
+ * @brief CandlestickChart::AppendCandles Add a batch of candles. Candles that are sorted and newer than the last
+ * candle are appended without searching the existing data, anything else is merged in.
+ * Appended candles only extend the index, and if the extents of the visible window did not move, only the candles that
+ * came into view are converted and repainted.
+ * @param pCandles: Array of (time, candle) pairs
+ * @param nCount: Number of pairs in pCandles
+ */
+void CandlestickChart::AppendCandles(const std::pair<uint32_t, Candle>* pCandles, size_t nCount)
+{
+    if (nCount == 0 || !OwnsCandles())
+        return;
+    bool fTail = MergeIntoMap(m_mapPoints, pCandles, nCount);
+    if (!fTail)
+        m_fCandleIndexDirty = true;
+
+    //Merges into the history, deferred updates and anything already waiting for a rescan are processed in full
+    if (!fTail || InUpdate() || m_fChangesMade || m_vCachedCandles.empty() || ChartArea() != m_rectCachedChart) {
+        DataChanged();
+        return;
+    }
+
+    //The window is found again from the extended index, which only costs the new candles
+    std::pair<double, double> pairXBefore = m_pairXRange;
+    std::pair<double, double> pairYBefore = m_pairYRange;
+    size_t nFirstBefore = m_nFirstVisible;
+    size_t nLastBefore = m_nLastVisible;
+    UpdateVisibleWindow();
+    if (m_pairXRange != pairXBefore || m_pairYRange != pairYBefore || m_nFirstVisible != nFirstBefore) {
+        //Every visible candle moved on screen, the next paint converts them again
+        update();
+        return;
+    }
+
+    //The candles on screen stay where they are, only the ones that came into view are added in front of them
+    m_fChangesMade = false;
+    QRegion region;
+    std::vector<std::pair<uint32_t, Candle>> vNewCandles;
+    for (size_t i = m_nLastVisible; i > nLastBefore; i--) {
+        std::pair<uint32_t, Candle> chartCandle = ConvertToCandlePlotPoint(CandleAt(i - 1));
+        if (chartCandle.second.isNull())
+            break;
+        region += CandleRect(chartCandle);
+        vNewCandles.emplace_back(chartCandle);
+    }
+    m_vCachedCandles.insert(m_vCachedCandles.begin(), vNewCandles.begin(), vNewCandles.end());
+    if (m_fDisplayOHLC && m_fOHLCShowsNewest) {
+        Candle candle;
+        if (NewestCandle(candle)) {
+            QString strOHLC = OHLCString(candle);
+            region += OHLCRect(m_strOHLC).united(OHLCRect(strOHLC));
+            m_strOHLC = strOHLC;
+        }
+    }
+    if (!region.isEmpty())
+        update(region);
+}
+
+void CandlestickChart::AppendCandles(const std::vector<std::pair<uint32_t, Candle>>& vCandles)
+{
+    if (vCandles.empty())
+        return;
+    AppendCandles(vCandles.data(), vCandles.size());
+}
+
+/**
+ * @brief CandlestickChart::SetDataView Draw candles straight from caller owned memory instead of copying them into the chart.
+ * The caller must keep the memory alive until the chart is given new data.
+ * @param view
+ */
+void CandlestickChart::SetDataView(const CandleView& view)
+{
+    ReleaseModel();
+    std::map<uint32_t, Candle>().swap(m_mapPoints);
+    m_viewCandles = view;
+    m_fExternalData = true;
+    m_pSource.reset();
+    m_snapshotCandles = ChunkedSeries<Candle>::Snapshot();
+    ReleaseTicks();
+    m_fCandleIndexDirty = true;
+    DataChanged();
+}
+
+/**
+ * @brief CandlestickChart::DataViewAppended Tell the chart that candles were appended to the memory behind its view.
+ * Only the newest candles that fit in the chart area are scanned for the extents.
+ * @param view: The grown view, which may point at a reallocated buffer
+ */
+void CandlestickChart::DataViewAppended(const CandleView& view)
+{
+    if (!m_fExternalData)
+        return;
+    m_viewCandles = view;
+    DataChanged();
+}
+
+/**
+ * @brief CandlestickChart::SetModel Draw the candles of a shared SeriesModel. The candles are built and kept up to date by the
+ * model, so charts showing the same model and period share them. The chart keeps a reference to the model and repaints when it changes.
+ * @param model
+ * @param candleTimePeriod: Candle period, 0 keeps the current period
+ */
+void CandlestickChart::SetModel(const std::shared_ptr<SeriesModel>& model, uint32_t candleTimePeriod)
+{
+    if (!model)
+        return;
+    if (candleTimePeriod)
         m_nCandleTimePeriod = candleTimePeriod;
+    ReleaseModel();
+    std::map<uint32_t, Candle>().swap(m_mapPoints);
+    m_viewCandles = CandleView();
+    m_fExternalData = false;
+    m_pSource.reset();
+    m_snapshotCandles = ChunkedSeries<Candle>::Snapshot();
+    ReleaseTicks();
+    m_pModel = model;
+    connect(m_pModel.get(), &SeriesModel::pointsAppended, this, &CandlestickChart::OnModelChanged);
+    connect(m_pModel.get(), &SeriesModel::pointsRemoved, this, &CandlestickChart::OnModelReset);
+    connect(m_pModel.get(), &SeriesModel::dataReset, this, &CandlestickChart::OnModelReset);
+    m_fCandleIndexDirty = true;
+    DataChanged();
+}
+
+/**
+ * @brief CandlestickChart::SetSource Draw candles that another thread appends to a ChunkedSeries. The chart draws a pinned
+ * snapshot and only picks up newer versions when it is repainted, so the writer never has to synchronize with the GUI thread.
+ * Call RefreshSource() after appending, queued when called from the writer thread.
+ * @param source
+ */
+void CandlestickChart::SetSource(const std::shared_ptr<ChunkedSeries<Candle>>& source)
+{
+    if (!source)
+        return;
+    ReleaseModel();
+    std::map<uint32_t, Candle>().swap(m_mapPoints);
+    m_viewCandles = CandleView();
+    m_fExternalData = false;
+    ReleaseTicks();
+    m_pSource = source;
+    m_snapshotCandles = source->Pin();
+    m_fCandleIndexDirty = true;
+    DataChanged();
+}
+
+/**
+ * @brief CandlestickChart::PinSnapshot Move to the newest published version of the source, rescanning the extents if it changed
+ */
+void CandlestickChart::PinSnapshot()
+{
+    if (!m_pSource)
+        return;
+    ChunkedSeries<Candle>::Snapshot snapshot = m_pSource->Pin();
+    if (snapshot.SameGeneration(m_snapshotCandles) && snapshot.Size() == m_snapshotCandles.Size())
+        return;
+    //A new generation rewrote the candles, within a generation they are only appended
+    if (!snapshot.SameGeneration(m_snapshotCandles))
+        m_fCandleIndexDirty = true;
+    m_snapshotCandles = snapshot;
+    DataChanged();
+}
+
+/**
+ * @brief CandlestickChart::CreateIngestor Create a queue that a feed thread pushes candles into without touching the chart.
+ * Once per frame the queued candles are merged into the chart. A candle with the time of one the chart already has replaces it,
+ * so a feed can keep republishing the forming candle. Creating another ingestor replaces the previous one.
+ * @param nCapacity: Candles that can be queued between two drains
+ * @param policy: What happens to candles that are pushed while the queue is full. COALESCE keeps the newest state of the forming candle.
+ * @return nullptr if the candles are read through a view, a model or a source, or built from ticks
+ */
+std::shared_ptr<Ingestor<Candle>> CandlestickChart::CreateIngestor(size_t nCapacity, IngestOverflow policy)
+{
+    if (!OwnsCandles())
+        return nullptr;
+    m_pIngestor = std::make_shared<Ingestor<Candle>>(nCapacity, policy);
+    StartIngestTimer();
+    return m_pIngestor;
+}
+
+/**
+ * @brief CandlestickChart::DrainIngestors Merge everything the ingestor queued since the last frame
+ * @return true if any candle changed
+ */
+bool CandlestickChart::DrainIngestors()
+{
+    //Candles read through a view, a model or a source, or built from ticks, can not be edited through the chart. The
+    //queue is left alone, so nothing is lost if the chart owns its candles again later.
+    if (!m_pIngestor || !OwnsCandles())
+        return false;
+    m_vIngestBuffer.clear();
+    if (m_pIngestor->Drain(m_vIngestBuffer) == 0)
+        return false;
+
+    //Every candle replaces the one with its time. Only updates of the newest candle and appends keep the index valid.
+    for (const auto& pair : m_vIngestBuffer) {
+        if (!m_mapPoints.empty() && pair.first < m_mapPoints.rbegin()->first)
+            m_fCandleIndexDirty = true;
+        m_mapPoints[pair.first] = pair.second;
     }
-    m_mapPoints = ConvertLineToCandlestickData(mapPoints, volPoints, m_nCandleTimePeriod);
-    ProcessChangedData();
+    DataChanged();
+    return true;
+}
+
+/**
+ * @brief CandlestickChart::RefreshSource Repaint if the source has a newer version than the one that is drawn
+ */
+void CandlestickChart::RefreshSource()
+{
+    if (!m_pSource)
+        return;
+    ChunkedSeries<Candle>::Snapshot snapshot = m_pSource->Pin();
+    if (!snapshot.SameGeneration(m_snapshotCandles) || snapshot.Size() != m_snapshotCandles.Size())
+        update();
+}
+
+void CandlestickChart::ReleaseModel()
+{
+    if (m_pModel)
+        disconnect(m_pModel.get(), nullptr, this, nullptr);
+    m_pModel.reset();
+}
+
+size_t CandlestickChart::CandleCount() const
+{
+    if (m_fExternalData)
+        return m_viewCandles.Size();
+    if (m_pSource)
+        return m_snapshotCandles.Size();
+    return CandleMap().size();
+}
+
+/**
+ * @brief CandlestickChart::CandleMap The candles when they are held in a map, by this chart, by its model or built from its ticks
+ */
+const std::map<uint32_t, Candle>& CandlestickChart::CandleMap() const
+{
+    if (m_pModel)
+        return m_pModel->Candles(m_nCandleTimePeriod);
+    if (m_fTickData)
+        return CachedCandles(m_nCandleTimePeriod);
+    return m_mapPoints;
+}
+
+/**
+ * @brief CandlestickChart::OnModelChanged The model changed. Only the newest candles that fit in the chart area are rescanned.
+ */
+void CandlestickChart::OnModelChanged()
+{
+    DataChanged();
+    update();
+}
+
+/**
+ * @brief CandlestickChart::OnModelReset Points were removed from the model or replaced, its candles are indexed again
+ */
+void CandlestickChart::OnModelReset()
+{
+    m_fCandleIndexDirty = true;
+    OnModelChanged();
 }
 
 /**
@@ -324,6 +881,9 @@ void CandlestickChart::SetDataPoints(std::map<uint32_t, double>& mapPoints, std:
  */
 void CandlestickChart::AddVolumePoint(const uint32_t& x, const double& y)
 {
+    //Candles read through a view, a model or a source, or built from ticks, can not be edited through the chart
+    if (!OwnsCandles())
+        return;
     std::map<uint32_t, Candle>::iterator it = m_mapPoints.find(x);
     if (it != m_mapPoints.end()) {
         it->second.m_volume = y;
@@ -331,7 +891,9 @@ void CandlestickChart::AddVolumePoint(const uint32_t& x, const double& y)
         Candle candle;
         candle.m_volume = y;
         m_mapPoints.emplace(x,candle);
+        m_fCandleIndexDirty = true;
     }
+    DataChanged();
 }
 
 /**
@@ -340,10 +902,13 @@ void CandlestickChart::AddVolumePoint(const uint32_t& x, const double& y)
  */
 void CandlestickChart::RemoveVolumePoint(const uint32_t &x)
 {
+    if (!OwnsCandles())
+        return;
     std::map<uint32_t, Candle>::iterator it = m_mapPoints.find(x);
     if (it != m_mapPoints.end()) {
         it->second.m_volume = 0;
     }
+    DataChanged();
 }
 
 /**
@@ -352,40 +917,168 @@ void CandlestickChart::RemoveVolumePoint(const uint32_t &x)
  */
 void CandlestickChart::SetVolumePoints(const std::map<uint32_t, double>& mapPoints)
 {
-    for(auto pair: mapPoints) {
+    //Candles built from ticks take their volume from the ticks
+    if (m_fTickData) {
+        AssignTickVolume(mapPoints);
+        m_mapCandleCache.clear();
+        m_fCandleIndexDirty = true;
+        DataChanged();
+        return;
+    }
+    UpdateBatch batch(this);
+    for(const auto& pair: mapPoints) {
         AddVolumePoint(pair.first, pair.second);
     }
 }
 
 void CandlestickChart::ProcessChangedData()
 {
-    m_pairXRange = {0, 0};
-    m_pairYRange = {0, 0};
-    bool fFirstRun = true;
-    m_nCandles = 0;
-    std::map<uint32_t, Candle>::reverse_iterator rit;
-    for (rit = m_mapPoints.rbegin(); rit != m_mapPoints.rend(); ++rit) {
-        // determine if candles are out of bounds
-        QRect rectChart = ChartArea();
-        int nWidth = rectChart.width();
-        double nValueX = (2*m_nCandles + 1) * m_nCandleWidth + 2*m_nCandleSpacing;
-        if(nValueX > nWidth) {
-            break;
-        } else {
-            m_nCandles++;
+    UpdateVisibleWindow();
+}
+
+/**
+ * @brief CandlestickChart::CandleAt The candle at an index of the time ordered candles. Map held candles go through the index.
+ */
+std::pair<uint32_t, Candle> CandlestickChart::CandleAt(size_t nIndex) const
+{
+    if (m_fExternalData)
+        return m_viewCandles.At(nIndex);
+    if (m_pSource)
+        return m_snapshotCandles.At(nIndex);
+    return *m_vCandleIndex[nIndex];
+}
+
+/**
+ * @brief CandlestickChart::CandleLowerBound Index of the first candle with a time at or after nTime, found by binary search
+ */
+size_t CandlestickChart::CandleLowerBound(uint32_t nTime) const
+{
+    size_t nFirst = 0;
+    size_t nLast = CandleCount();
+    while (nFirst < nLast) {
+        size_t nMid = nFirst + (nLast - nFirst) / 2;
+        if (CandleAt(nMid).first < nTime)
+            nFirst = nMid + 1;
+        else
+            nLast = nMid;
+    }
+    return nFirst;
+}
+
+/**
+ * @brief CandlestickChart::ExtendCandleIndex Add candles appended past the indexed ones to the index and the range min/max
+ * structure, and refresh the newest indexed candle, which may be a forming candle that was updated in place
+ * @return false if candles were inserted before the newest indexed candle, the index then has to be rebuilt
+ */
+bool CandlestickChart::ExtendCandleIndex(size_t nCount)
+{
+    size_t nIndexed = m_rangeCandles.Size();
+    if (!m_fExternalData && !m_pSource) {
+        //Map iterators stay valid while candles are added, so everything after the newest indexed candle is new
+        const std::map<uint32_t, Candle>& mapCandles = CandleMap();
+        if (m_vCandleIndex.size() != nIndexed)
+            return false;
+        auto it = nIndexed > 0 ? std::next(m_vCandleIndex.back()) : mapCandles.begin();
+        for (; it != mapCandles.end(); ++it)
+            m_vCandleIndex.emplace_back(it);
+        if (m_vCandleIndex.size() != nCount)
+            return false;
+    }
+
+    if (nIndexed > 0) {
+        std::pair<uint32_t, Candle> pair = CandleAt(nIndexed - 1);
+        m_rangeCandles.Set(nIndexed - 1, pair.second.m_low, pair.second.m_high);
+    }
+    for (size_t i = nIndexed; i < nCount; i++) {
+        std::pair<uint32_t, Candle> pair = CandleAt(i);
+        m_rangeCandles.Append(pair.second.m_low, pair.second.m_high);
+    }
+    return true;
+}
+
+/**
+ * @brief CandlestickChart::SyncCandleIndex Bring the index of map held candles and the range min/max structure up to date after
+ * the candles changed. Appends only cost the new candles, the whole history is only indexed again after the candles were
+ * replaced or changed before the newest candle.
+ */
+void CandlestickChart::SyncCandleIndex()
+{
+    size_t nCountBefore = m_nSyncedCandles;
+    size_t nCount = CandleCount();
+    if (m_fExternalData && m_viewCandles.RangeIndex()) {
+        //The view answers range queries from its own index, building one here would read every candle of a mapped file
+        m_rangeCandles.Clear();
+    } else if (m_fCandleIndexDirty || nCount < m_rangeCandles.Size() || !ExtendCandleIndex(nCount)) {
+        m_vCandleIndex.clear();
+        m_rangeCandles.Clear();
+        if (!m_fExternalData && !m_pSource) {
+            const std::map<uint32_t, Candle>& mapCandles = CandleMap();
+            m_vCandleIndex.reserve(mapCandles.size());
+            for (auto it = mapCandles.begin(); it != mapCandles.end(); ++it)
+                m_vCandleIndex.emplace_back(it);
         }
 
-        //Set min and max for x and y
-        if (fFirstRun || rit->first < m_pairXRange.first)
-            m_pairXRange.first = rit->first;
-        if (fFirstRun || rit->first > m_pairXRange.second)
-            m_pairXRange.second = rit->first;
-        if (fFirstRun || rit->second.m_low < m_pairYRange.first)
-            m_pairYRange.first = rit->second.m_low;
-        if (fFirstRun || rit->second.m_high > m_pairYRange.second)
-            m_pairYRange.second = rit->second.m_high;
-        fFirstRun = false;
+        m_rangeCandles.Reserve(nCount);
+        for (size_t i = 0; i < nCount; i++) {
+            std::pair<uint32_t, Candle> pair = CandleAt(i);
+            m_rangeCandles.Append(pair.second.m_low, pair.second.m_high);
+        }
     }
+
+    //A chart scrolled into its history keeps showing the same candles while new ones arrive
+    if (m_nScrollOffset > 0 && nCount > nCountBefore)
+        m_nScrollOffset += nCount - nCountBefore;
+    m_nSyncedCandles = nCount;
+    m_fCandleIndexDirty = false;
+}
+
+/**
+ * @brief CandlestickChart::CandleRange Lowest low and highest high of the candles in [nFirst, nLast)
+ */
+bool CandlestickChart::CandleRange(size_t nFirst, size_t nLast, double& dLow, double& dHigh) const
+{
+    if (m_fExternalData && m_viewCandles.RangeIndex())
+        return m_viewCandles.MinMaxAt(nFirst, nLast, dLow, dHigh);
+    return m_rangeCandles.Query(nFirst, nLast, dLow, dHigh);
+}
+
+/**
+ * @brief CandlestickChart::UpdateVisibleWindow Find the candles that fit in the chart area at the current scroll offset.
+ * The extents of the window come from the range min/max structure or the range index of the view, so only the two ends of the window are read.
+ */
+void CandlestickChart::UpdateVisibleWindow()
+{
+    SyncCandleIndex();
+    size_t nCount = CandleCount();
+
+    // determine how many candles fit in the chart area
+    int nWidth = ChartArea().width();
+    size_t nFit = 0;
+    while (m_nCandleWidth > 0 && nFit < nCount && (2*nFit + 1) * m_nCandleWidth + 2*m_nCandleSpacing <= nWidth)
+        nFit++;
+
+    m_nScrollOffset = std::min(m_nScrollOffset, nCount > 0 ? nCount - 1 : 0);
+    m_nLastVisible = nCount - m_nScrollOffset;
+    m_nFirstVisible = m_nLastVisible - std::min(m_nLastVisible, nFit);
+
+    m_pairXRange = {0, 0};
+    m_pairYRange = {0, 0};
+    std::pair<double, double> pairLinked;
+    if (LinkedXRange(pairLinked)) {
+        //The x range shared by the group picks the candles instead of the scroll offset
+        uint32_t nStart, nEnd;
+        m_pChartGroup->XRangeTimes(nStart, nEnd);
+        m_nFirstVisible = CandleLowerBound(nStart);
+        m_nLastVisible = nEnd < std::numeric_limits<uint32_t>::max() ? CandleLowerBound(nEnd + 1) : nCount;
+        m_nLastVisible = std::max(m_nFirstVisible, m_nLastVisible);
+        m_pairXRange = pairLinked;
+        if (m_nFirstVisible < m_nLastVisible)
+            CandleRange(m_nFirstVisible, m_nLastVisible, m_pairYRange.first, m_pairYRange.second);
+    } else if (m_nFirstVisible < m_nLastVisible) {
+        m_pairXRange = {CandleAt(m_nFirstVisible).first, CandleAt(m_nLastVisible - 1).first};
+        CandleRange(m_nFirstVisible, m_nLastVisible, m_pairYRange.first, m_pairYRange.second);
+    }
+    m_pairYDataRange = m_pairYRange;
     // Add y-axis buffer for candlestick data
     double buffer = m_yPadding * (m_pairYRange.second - m_pairYRange.first) / 20;
     m_pairYRange.second += buffer;
@@ -397,9 +1090,145 @@ void CandlestickChart::ProcessChangedData()
     m_fChangesMade = true;
 }
 
+/**
+ * @brief CandlestickChart::UpdateCachedCandles Convert the visible candles to screen coordinates, newest first
+ */
+void CandlestickChart::UpdateCachedCandles()
+{
+    m_vCachedCandles.clear();
+    m_rectCachedChart = ChartArea();
+    for (size_t i = m_nLastVisible; i > m_nFirstVisible; i--) {
+        std::pair<uint32_t, Candle> chartCandle = ConvertToCandlePlotPoint(CandleAt(i - 1));
+        if (chartCandle.second.isNull())
+            break;
+        m_vCachedCandles.emplace_back(chartCandle);
+    }
+}
+
+/**
+ * @brief CandlestickChart::CandleRect The area a converted candle paints over, including its wick, dashes, outline and volume bar
+ */
+QRect CandlestickChart::CandleRect(const std::pair<uint32_t, Candle>& chartCandle) const
+{
+    //Screen y grows downwards, so the high is the top of the candle
+    double dTop = chartCandle.second.m_high;
+    double dBottom = chartCandle.second.m_low;
+    if (m_fDrawVolume) {
+        dTop = std::min(dTop, chartCandle.second.m_volume);
+        dBottom = ChartArea().bottom();
+    }
+    double dMargin = m_nCandleLineWidth + 1;
+    QPointF pointTopLeft(chartCandle.first - m_nCandleWidth - dMargin, dTop - dMargin);
+    QPointF pointBottomRight(chartCandle.first + m_nCandleWidth + dMargin, dBottom + dMargin);
+    return QRectF(pointTopLeft, pointBottomRight).toAlignedRect();
+}
+
+/**
+ * @brief CandlestickChart::ConvertToAnnotationPoint: convert a time and value into the point an annotation is painted to,
+ * on the same x as the center of the candle at that time
+ */
+QPointF CandlestickChart::ConvertToAnnotationPoint(uint32_t nTime, double dValue) const
+{
+    QRect rectChart = ChartArea();
+    if (m_yPadding > 0) {
+        rectChart.setBottom(rectChart.bottom() - m_yPadding);
+        rectChart.setTop(rectChart.top() + m_yPadding);
+    }
+
+    double dSpanX = MaxX() - MinX();
+    double x = rectChart.left() - m_nCandleWidth;
+    if (dSpanX > 0)
+        x += (nTime - MinX()) / dSpanX * rectChart.width();
+
+    double dSpanY = MaxY() - MinY();
+    double y = rectChart.top() + rectChart.height() / 2.0;
+    if (dSpanY > 0)
+        y = rectChart.bottom() - (dValue - MinY()) / dSpanY * rectChart.height();
+    return QPointF(x, y);
+}
+
+/**
+ * @brief CandlestickChart::ConvertToPlotX: screen x of the center of the candle at dX
+ */
+double CandlestickChart::ConvertToPlotX(double dX) const
+{
+    return Chart::ConvertToPlotX(dX) - m_nCandleWidth;
+}
+
+double CandlestickChart::ConvertFromPlotX(double x) const
+{
+    return Chart::ConvertFromPlotX(x + m_nCandleWidth);
+}
+
+/**
+ * @brief CandlestickChart::LinkedHoverRegion: The crosshair at dX and the OHLC header, which shows the candle at dX
+ */
+QRegion CandlestickChart::LinkedHoverRegion(double dX)
+{
+    //The cached candles are out of date, the next paint rebuilds them
+    if (m_fChangesMade || ChartArea() != m_rectCachedChart)
+        return QRegion(rect());
+
+    QRegion region = Chart::LinkedHoverRegion(dX);
+    if (m_fDisplayOHLC) {
+        //The header goes back to the forming candle when the hover ends
+        region += OHLCRect(m_strOHLC);
+        Candle candle;
+        if (NearestCandle(static_cast<uint32_t>(std::max(0.0, dX)), candle))
+            region += OHLCRect(OHLCString(candle));
+        if (NewestCandle(candle))
+            region += OHLCRect(OHLCString(candle));
+    }
+    return region;
+}
+
+/**
+ * @brief CandlestickChart::NewestCandle: the forming candle
+ * @return false if there are no candles
+ */
+bool CandlestickChart::NewestCandle(Candle& candle) const
+{
+    if (CandleCount() == 0)
+        return false;
+    if (m_fExternalData)
+        candle = m_viewCandles.At(m_viewCandles.Size() - 1).second;
+    else if (m_pSource)
+        candle = m_snapshotCandles.Y(m_snapshotCandles.Size() - 1);
+    else
+        candle = CandleMap().rbegin()->second;
+    return true;
+}
+
+QString CandlestickChart::OHLCString(const Candle& candle) const
+{
+    QString strOHLC = "O:" + QString::number(candle.m_open) + "\t";
+    strOHLC += "H:" + QString::number(candle.m_high) + "\t";
+    strOHLC += "L:" + QString::number(candle.m_low) + "\t";
+    strOHLC += "C:" + QString::number(candle.m_close) + "\t";
+    if (m_fDrawVolume) {
+        strOHLC += "V:" + QString::number(candle.m_volume) + "\t";
+    }
+    //A zero open has no percentage change, show 0 rather than inf or nan
+    double dChange = candle.m_open != 0 ? (candle.m_close - candle.m_open) / candle.m_open : 0;
+    strOHLC += QString::number(dChange) + "%";
+    return strOHLC;
+}
+
+/**
+ * @brief CandlestickChart::OHLCRect: the area the OHLC header text is drawn in, laid out the same way paintEvent draws it
+ */
+QRect CandlestickChart::OHLCRect(const QString& strOHLC) const
+{
+    QRect rectInfo = rect();
+    rectInfo.setBottom(rectInfo.top() + HeightTopTitleArea());
+    QFontMetrics fm(m_fontOHLC);
+    return fm.boundingRect(rectInfo, Qt::AlignRight, strOHLC).adjusted(-1, -1, 1, 1);
+}
+
 void CandlestickChart::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
+    //Draw the newest version of the source, it stays pinned until the next paint
+    PinSnapshot();
 
     //Fill in the background first
     QPainter painter(this);
@@ -408,7 +1237,7 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
     painter.fillRect(rect(), m_brushBackground);
 
     //If there is only one data point, then return without drawing anything but the background
-    if (m_mapPoints.size() <= 1) {
+    if (CandleCount() <= 1) {
         return;
     }
 
@@ -443,10 +1272,15 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
         }
     }
 
-    ProcessChangedData();
     QRect rectFull = rect();
     QRect rectChart = ChartArea();
 
+    //The visible candles depend on the chart area, settings and scroll offset, data changes were already processed by the mutators
+    if (m_fChangesMade || rectChart != m_rectCachedChart) {
+        UpdateVisibleWindow();
+        UpdateCachedCandles();
+    }
+
     // Determine if mouse location is inside of the chart
     QPoint gposMouse = QCursor::pos();
     QPoint gposChart = mapToGlobal(QPoint(0+WidthYTitleArea()+WidthYLabelArea(),0+HeightTopTitleArea()));
@@ -461,6 +1295,12 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
         }
      }
 
+    //The mouse is over another chart of the group, show the candle at the same x
+    QPoint pointLinked;
+    bool fLinkedHover = !fMouseInChartArea && LinkedHoverPoint(pointLinked);
+    if (fLinkedHover)
+        lposMouse = pointLinked;
+
     //Draw axis sections
     if (m_axisSections > 0) {
         painter.save();
@@ -502,7 +1342,7 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
             DrawXLabels(painter, vXPoints, /*drawIndicatorLine*/true);
 
             // Give detail about where mouse is located
-            if (m_mousedisplay.IsEnabled() && fMouseInChartArea) {
+            if (m_mousedisplay.IsEnabled() && (fMouseInChartArea || fLinkedHover)) {
                 //Draw the x label
                 DrawXLabels(painter, {lposMouse.x()}, /*drawIndicatorLine*/false);
             }
@@ -512,12 +1352,7 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
     //Draw Candlesticks
     QPen penCandle;
     penCandle.setWidth(m_nCandleLineWidth);
-    std::map<uint32_t, Candle>::reverse_iterator rit;
-    for (rit = m_mapPoints.rbegin(); rit != m_mapPoints.rend(); ++rit) {
-        std::pair<uint32_t, Candle> chartCandle = ConvertToCandlePlotPoint(*rit);
-        if (chartCandle.second.isNull()) {
-            break;
-        }
+    auto drawCandle = [&](const std::pair<uint32_t, Candle>& chartCandle) {
         QPointF pointO = QPointF(chartCandle.first, chartCandle.second.m_open);
         QPointF pointH = QPointF(chartCandle.first, chartCandle.second.m_high);
         QPointF pointL = QPointF(chartCandle.first, chartCandle.second.m_low);
@@ -606,6 +1441,15 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
             painter.setBrush(rectBrush);
             painter.drawRect(rect);
         }
+    };
+    if (event->region().contains(rectChart)) {
+        std::for_each(m_vCachedCandles.begin(), m_vCachedCandles.end(), drawCandle);
+    } else {
+        //Partial repaint, usually the forming candle, so only the candles inside the dirty area are drawn
+        for (const auto& chartCandle : m_vCachedCandles) {
+            if (event->region().intersects(CandleRect(chartCandle)))
+                drawCandle(chartCandle);
+        }
     }
     painter.save();
     painter.restore();
@@ -616,33 +1460,36 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
         penLine.setWidth(m_lineWidth);
         painter.setPen(penLine);
         painter.setFont(m_fontOHLC);
-        if(fMouseInChartArea) {
+        // Show the candle the mouse is closest to, otherwise the forming candle
+        Candle currentCandle;
+        bool fHaveCandle;
+        if (fMouseInChartArea) {
             uint32_t nTime = ConvertCandlePlotPointTime(lposMouse);
-            // Calculate the candle the mouse is closest to and change OHLC
-            std::map<uint32_t, Candle>::iterator candleUpper = m_mapPoints.upper_bound(nTime - m_nCandleTimePeriod);
-            std::map<uint32_t, Candle>::iterator candleLower = m_mapPoints.lower_bound(nTime - m_nCandleTimePeriod);
-            int upperDist = std::abs(static_cast<int>(candleUpper->first) - static_cast<int>(nTime));
-            int lowerDist = std::abs(static_cast<int>(candleLower->first) - static_cast<int>(nTime));
-            Candle currentCandle;
-            if (upperDist > lowerDist) {
-                currentCandle = candleLower->second;
-            } else {
-                currentCandle = candleUpper->second;
-            }
-            m_strOHLC = "O:" + QString::number(currentCandle.m_open) + "\t";
-            m_strOHLC += "H:" + QString::number(currentCandle.m_high) + "\t";
-            m_strOHLC += "L:" + QString::number(currentCandle.m_low) + "\t";
-            m_strOHLC += "C:" + QString::number(currentCandle.m_close) + "\t";
-            if (m_fDrawVolume) {
-                m_strOHLC += "V:" + QString::number(currentCandle.m_volume) + "\t";
-            }
-            m_strOHLC += QString::number((currentCandle.m_close - currentCandle.m_open)/ currentCandle.m_open)+ "%";
+            fHaveCandle = NearestCandle(nTime, currentCandle);
+            m_fOHLCShowsNewest = false;
+        } else if (fLinkedHover) {
+            fHaveCandle = NearestCandle(static_cast<uint32_t>(std::max(0.0, m_dLinkedHoverX)), currentCandle);
+            m_fOHLCShowsNewest = false;
+        } else {
+            fHaveCandle = NewestCandle(currentCandle);
+            m_fOHLCShowsNewest = true;
         }
+        //Without candles the header keeps what it showed, which starts out as all zeros
+        if (fHaveCandle)
+            m_strOHLC = OHLCString(currentCandle);
         QRect rectInfo = rectFull;
         rectInfo.setBottom(rectFull.top() + HeightTopTitleArea());
         painter.drawText(rectInfo, Qt::AlignRight, m_strOHLC);
     }
 
+    //Draw annotations over the candles, only the ones inside the visible range are visited
+    if (!m_annotations.Empty()) {
+        AnnotationBox boxVisible(static_cast<uint32_t>(std::max(0.0, MinX())), static_cast<uint32_t>(std::max(0.0, std::ceil(MaxX()))), MinY(), MaxY());
+        m_annotations.Paint(painter, rectChart, boxVisible, [this](uint32_t nTime, double dValue) {
+            return ConvertToAnnotationPoint(nTime, dValue);
+        });
+    }
+
     //Draw axis
     if (m_fDrawXAxis) {
         QLineF axisX(rectChart.bottomLeft(), rectChart.bottomRight());
@@ -685,14 +1532,16 @@ void CandlestickChart::paintEvent(QPaintEvent *event)
         painter.restore();
     }
 
-    //Draw mouse display
-    if (m_mousedisplay.IsEnabled() && fMouseInChartArea) {
+    //Draw mouse display, a linked hover only has an x so it only gets the vertical line
+    if (m_mousedisplay.IsEnabled() && (fMouseInChartArea || fLinkedHover)) {
         //Cross hair lines
         painter.setPen(m_mousedisplay.Pen());
-        QPointF posLeft(rectChart.left(), lposMouse.y());
-        QPointF posRight(rectChart.right(), lposMouse.y());
-        QLineF lineMouseX(posLeft, posRight);
-        painter.drawLine(lineMouseX);
+        if (fMouseInChartArea) {
+            QPointF posLeft(rectChart.left(), lposMouse.y());
+            QPointF posRight(rectChart.right(), lposMouse.y());
+            QLineF lineMouseX(posLeft, posRight);
+            painter.drawLine(lineMouseX);
+        }
         QPointF posTop(lposMouse.x(), rectChart.top());
         QPointF posBottom(lposMouse.x(), rectChart.bottom());
         painter.drawLine(QLineF(posTop, posBottom));
@@ -765,6 +1614,12 @@ void CandlestickChart::SetCandleTimePeriod(uint32_t nTime)
 {
     m_nCandleTimePeriod = nTime;
     m_fChangesMade = true;
+
+    //Model candles and candles built from ticks depend on the period, cached periods switch without rebuilding
+    if (m_pModel || m_fTickData) {
+        m_fCandleIndexDirty = true;
+        DataChanged();
+    }
 }
 
 void CandlestickChart::SetOLHCFont(const QFont &font)
@@ -801,10 +1656,73 @@ void CandlestickChart::EnableOHLCDisplay(bool fEnable)
 void CandlestickChart::EnableVolumeBar(bool fEnable)
 {
     m_fDrawVolume = fEnable;
+    m_fChangesMade = true;
+}
+
+/**
+ * @brief CandlestickChart::ScrollCandles Scroll through the candle history
+ * @param nCandles: Candles to move back in time, negative values move towards the newest candle
+ */
+void CandlestickChart::ScrollCandles(int nCandles)
+{
+    if (nCandles < 0 && static_cast<size_t>(-nCandles) > m_nScrollOffset)
+        SetScrollOffset(0);
+    else
+        SetScrollOffset(m_nScrollOffset + nCandles);
+}
+
+/**
+ * @brief CandlestickChart::SetScrollOffset Show the history ending nOffset candles before the newest candle. An offset of 0 follows
+ * the newest candle as new candles arrive, any other offset keeps showing the same candles.
+ */
+void CandlestickChart::SetScrollOffset(size_t nOffset)
+{
+    if (nOffset == m_nScrollOffset)
+        return;
+    m_nScrollOffset = nOffset;
+    m_fChangesMade = true;
+    update();
+}
+
+void CandlestickChart::mousePressEvent(QMouseEvent *event)
+{
+    //A linked x axis is panned by Chart for the whole group
+    if (event->button() == Qt::LeftButton && !XAxisLinked() && ChartArea().contains(event->pos())) {
+        m_fPanning = true;
+        m_pointPanStart = event->pos();
+        m_nPanStartOffset = m_nScrollOffset;
+    }
+    Chart::mousePressEvent(event);
+}
+
+void CandlestickChart::mouseMoveEvent(QMouseEvent *event)
+{
+    if (m_fPanning) {
+        //Dragging to the right pulls older candles into view
+        size_t nVisible = std::max<size_t>(1, m_nLastVisible - m_nFirstVisible);
+        double dPitch = std::max(1.0, static_cast<double>(ChartArea().width()) / nVisible);
+        int nCandles = static_cast<int>((event->pos().x() - m_pointPanStart.x()) / dPitch);
+        if (nCandles < 0 && static_cast<size_t>(-nCandles) > m_nPanStartOffset)
+            SetScrollOffset(0);
+        else
+            SetScrollOffset(m_nPanStartOffset + nCandles);
+    }
+    Chart::mouseMoveEvent(event);
+}
+
+void CandlestickChart::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        m_fPanning = false;
+    Chart::mouseReleaseEvent(event);
 }
 
 void CandlestickChart::wheelEvent(QWheelEvent *event)
 {
+    if (XAxisLinked()) {
+        Chart::wheelEvent(event);
+        return;
+    }
     int dCandleWidth = event->angleDelta().y()/120;
     if ((m_nCandleWidth > m_nCandleMinWidth && dCandleWidth < 0)
             || (m_nCandleWidth < m_nCandleMaxWidth && dCandleWidth > 0)) {
@@ -825,4 +1743,49 @@ std::vector<std::pair<QString, QColor>> CandlestickChart::GetLegendData()
     return vLegend;
 }
 
+/**
+ * @brief CandlestickChart::AddAnnotationPoint : Mark a single value, the annotations are drawn over the series
+ */
+void CandlestickChart::AddAnnotationPoint(uint32_t nTime, double dValue, const QColor& color, const QString& strText)
+{
+    m_annotations.AddPoint(nTime, dValue, color, strText);
+    m_fChangesMade = true;
+    update();
+}
+
+void CandlestickChart::AddAnnotationRect(uint32_t nTimeFirst, uint32_t nTimeLast, double dLow, double dHigh, const QColor& color, const QString& strText)
+{
+    m_annotations.AddRect(nTimeFirst, nTimeLast, dLow, dHigh, color, strText);
+    m_fChangesMade = true;
+    update();
+}
+
+void CandlestickChart::AddAnnotationLabel(uint32_t nTime, double dValue, const QString& strText, const QColor& color)
+{
+    m_annotations.AddLabel(nTime, dValue, strText, color);
+    m_fChangesMade = true;
+    update();
+}
+
+void CandlestickChart::AddAnnotationLine(double dValue, const QColor& color, const QString& strText)
+{
+    m_annotations.AddHorizontalLine(dValue, color, strText);
+    m_fChangesMade = true;
+    update();
+}
+
+void CandlestickChart::ClearAnnotations()
+{
+    m_annotations.Clear();
+    m_fChangesMade = true;
+    update();
+}
+
+void CandlestickChart::SetAnnotationMarkerSize(int nSize)
+{
+    m_annotations.SetMarkerSize(nSize);
+    m_fChangesMade = true;
+    update();
+}
+
 }//namespace
@@ -26,8 +26,13 @@ SOFTWARE.
 #define CANDLESTICKCHART_H
 
 #include "chart.h"
+#include "annotationlayer.h"
 #include "axislabelsettings.h"
+#include "chunkedseries.h"
+#include "ingestor.h"
 #include "mousedisplay.h"
+#include "rangeindex.h"
+#include "seriesview.h"
 
 #include <QBrush>
 #include <QPen>
@@ -37,13 +42,17 @@ SOFTWARE.
 #include <QWheelEvent>
 
 #include <list>
+#include <memory>
 #include <set>
 
 class QColor;
+class QMouseEvent;
 class QPaintEvent;
 
 namespace PssCharts {
 
+class SeriesModel;
+
 struct Candle {
     double m_open;
     double m_high;
@@ -75,23 +84,152 @@ struct Candle {
     }
 };
 
+/**
+ * @brief CandleView: Non-owning view of candles held in caller owned memory, either as separate arrays
+ * or as an array of structs. nStride is the distance in bytes between two records and applies to every
+ * column, a stride of 0 means each column is a tightly packed array of its own type.
+ * The times must be strictly increasing. pVolume may be null, in which case every candle has no volume.
+ */
+class CandleView
+{
+    StridedColumn<uint32_t> m_columnTime;
+    StridedColumn<double> m_columnOpen;
+    StridedColumn<double> m_columnHigh;
+    StridedColumn<double> m_columnLow;
+    StridedColumn<double> m_columnClose;
+    StridedColumn<double> m_columnVolume;
+    size_t m_nSize;
+    const ViewRangeIndex* m_pRangeIndex;
+
+public:
+    typedef std::pair<uint32_t, Candle> value_type;
+    typedef ViewIterator<CandleView> const_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    CandleView() : m_nSize(0), m_pRangeIndex(nullptr) {}
+    CandleView(const uint32_t* pTime, const double* pOpen, const double* pHigh, const double* pLow, const double* pClose,
+               const double* pVolume, size_t nSize, size_t nStride = 0)
+        : m_columnTime(pTime, nStride), m_columnOpen(pOpen, nStride), m_columnHigh(pHigh, nStride), m_columnLow(pLow, nStride),
+          m_columnClose(pClose, nStride), m_columnVolume(pVolume, nStride), m_nSize(nSize), m_pRangeIndex(nullptr) {}
+
+    size_t Size() const { return m_nSize; }
+    bool Empty() const { return m_nSize == 0; }
+    uint32_t Time(size_t i) const { return m_columnTime[i]; }
+    value_type At(size_t i) const
+    {
+        //Caller data is not validated, so the throwing constructor is bypassed
+        Candle candle;
+        candle.m_open = m_columnOpen[i];
+        candle.m_high = m_columnHigh[i];
+        candle.m_low = m_columnLow[i];
+        candle.m_close = m_columnClose[i];
+        candle.m_volume = m_columnVolume.IsNull() ? 0 : m_columnVolume[i];
+        return value_type(m_columnTime[i], candle);
+    }
+
+    //! The index must outlive the view, the same as the memory behind it
+    void SetRangeIndex(const ViewRangeIndex* pIndex) { m_pRangeIndex = pIndex; }
+    const ViewRangeIndex* RangeIndex() const { return m_pRangeIndex; }
+
+    //! Lowest low and highest high of the candles in [nFirst, nLast), read from the range index if there is one
+    bool MinMaxAt(size_t nFirst, size_t nLast, double& dLow, double& dHigh) const
+    {
+        if (nLast > m_nSize)
+            nLast = m_nSize;
+        if (nFirst >= nLast)
+            return false;
+        if (m_pRangeIndex)
+            return m_pRangeIndex->RowRange(nFirst, nLast, dLow, dHigh);
+        dLow = m_columnLow[nFirst];
+        dHigh = m_columnHigh[nFirst];
+        for (size_t i = nFirst + 1; i < nLast; i++) {
+            dLow = std::min(dLow, m_columnLow[i]);
+            dHigh = std::max(dHigh, m_columnHigh[i]);
+        }
+        return true;
+    }
+
+    //! Index of the first candle with a time that is not less than nTime
+    size_t LowerBound(uint32_t nTime) const
+    {
+        size_t nLow = 0;
+        size_t nHigh = m_nSize;
+        while (nLow < nHigh) {
+            size_t nMid = nLow + (nHigh - nLow) / 2;
+            if (m_columnTime[nMid] < nTime)
+                nLow = nMid + 1;
+            else
+                nHigh = nMid;
+        }
+        return nLow;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_nSize); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+};
+
 class CandlestickChart : public Chart
 {
     Q_OBJECT
 
 protected:
     std::map<uint32_t, Candle> m_mapPoints;
+    CandleView m_viewCandles; //! Caller owned candles, used instead of m_mapPoints when m_fExternalData is set
+    bool m_fExternalData;
+    std::shared_ptr<SeriesModel> m_pModel; //! Shared points whose candles are used instead of m_mapPoints when set
+    std::shared_ptr<ChunkedSeries<Candle>> m_pSource; //! Candles written by another thread, read through m_snapshotCandles when set
+    ChunkedSeries<Candle>::Snapshot m_snapshotCandles; //! Version of m_pSource that is drawn until the next paint
+    std::shared_ptr<Ingestor<Candle>> m_pIngestor; //! Queue a feed thread pushes candles into
+    std::vector<std::pair<uint32_t, Candle>> m_vIngestBuffer; //! Reused between drains
+    std::vector<uint32_t> m_vTickTime; //! Retained ticks the candles of every period are built from when m_fTickData is set, in time order
+    std::vector<double> m_vTickPrice;
+    std::vector<double> m_vTickVolume;
+    bool m_fTickData;
+    mutable std::map<uint32_t, std::map<uint32_t, Candle>> m_mapCandleCache; //! Candles of each requested period, built on first use
+    const std::map<uint32_t, Candle>& CandleMap() const;
+    const std::map<uint32_t, Candle>& CachedCandles(uint32_t nPeriod) const;
+    static bool AddToBucket(std::map<uint32_t, Candle>& mapCandles, uint32_t nBucket, const Candle& candle);
+    bool AddTickToCache(uint32_t nTime, double dPrice, double dVolume);
+    bool OwnsCandles() const { return !m_fExternalData && !m_pModel && !m_pSource && !m_fTickData; }
+    size_t CandleCount() const;
+    void ReleaseModel();
+    void ReleaseTicks();
+    void UseTicks(uint32_t candleTimePeriod);
+    void AssignTickVolume(const std::map<uint32_t, double>& volPoints);
+    void PinSnapshot();
+    bool NearestCandle(uint32_t nTime, Candle& candle) const;
     std::pair<uint32_t, double> ConvertFromPlotPoint(const QPointF& point) override;
 
     void ProcessChangedData() override;
+    bool DrainIngestors() override;
+    void UpdateCachedCandles();
+    void SyncCandleIndex();
+    bool ExtendCandleIndex(size_t nCount);
+    bool CandleRange(size_t nFirst, size_t nLast, double& dLow, double& dHigh) const;
+    void UpdateVisibleWindow();
+    std::pair<uint32_t, Candle> CandleAt(size_t nIndex) const;
+    size_t CandleLowerBound(uint32_t nTime) const;
+    QRect CandleRect(const std::pair<uint32_t, Candle>& chartCandle) const;
+    QPointF ConvertToAnnotationPoint(uint32_t nTime, double dValue) const;
+    double ConvertToPlotX(double dX) const override;
+    double ConvertFromPlotX(double x) const override;
+    QRegion LinkedHoverRegion(double dX) override;
+    bool NewestCandle(Candle& candle) const;
+    QString OHLCString(const Candle& candle) const;
+    QRect OHLCRect(const QString& strOHLC) const;
 
     std::pair<uint32_t, Candle> ConvertToCandlePlotPoint(const std::pair<uint32_t, Candle>& pair);
     uint32_t ConvertCandlePlotPointTime(const QPointF& point);
-    std::map<uint32_t, Candle> ConvertLineToCandlestickData(const std::map<uint32_t, double> lineChartData, uint32_t candleTimePeriod);
-    std::map<uint32_t, Candle> ConvertLineToCandlestickData(const std::map<uint32_t, double> lineChartData, std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod);
+    std::map<uint32_t, Candle> ConvertLineToCandlestickData(const std::map<uint32_t, double>& lineChartData, uint32_t candleTimePeriod);
+    std::map<uint32_t, Candle> ConvertLineToCandlestickData(const std::map<uint32_t, double>& lineChartData, const std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod);
 
     void wheelEvent(QWheelEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
 
     bool m_fIsLineChart;
     bool m_fFillCandle;
@@ -121,6 +259,23 @@ protected:
     QColor m_colorVolume;
     QFont m_fontOHLC;
     QString m_strOHLC;
+    bool m_fOHLCShowsNewest; //! The OHLC header shows the forming candle rather than the candle under the mouse
+
+    std::vector<std::pair<uint32_t, Candle>> m_vCachedCandles; //! Screen geometry of the drawn candles, newest first
+    QRect m_rectCachedChart; //! Chart area the cached candles were converted for
+    std::pair<double, double> m_pairYDataRange; //! Lowest low and highest high of the visible candles, before the axis buffer
+
+    std::vector<std::map<uint32_t, Candle>::const_iterator> m_vCandleIndex; //! Map held candles by index, in time order
+    RangeMinMax m_rangeCandles; //! Lowest low and highest high of any range of candle indexes
+    bool m_fCandleIndexDirty; //! The candles changed since the index was built
+    size_t m_nSyncedCandles; //! Candle count when the index was last brought up to date
+    size_t m_nScrollOffset; //! Newest candles scrolled out on the right, 0 follows the newest candle
+    size_t m_nFirstVisible; //! Visible window [m_nFirstVisible, m_nLastVisible) of candle indexes
+    size_t m_nLastVisible;
+    bool m_fPanning;
+    QPoint m_pointPanStart;
+    size_t m_nPanStartOffset;
+    AnnotationLayer m_annotations; //! Trade markers and other notes drawn over the candles
 
 public:
     CandlestickChart(QWidget* parent = nullptr);
@@ -136,9 +291,19 @@ public:
     void EnableOHLCDisplay(bool fEnable);
     void EnableVolumeBar(bool fEnable);
 
-    void SetDataPoints(std::map<uint32_t, Candle>& mapPoints);
-    void SetDataPoints(std::map<uint32_t, double>& mapPoints, uint32_t candleTimePeriod = 0);
-    void SetDataPoints(std::map<uint32_t, double>& mapPoints, std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod = 0);
+    void SetDataPoints(const std::map<uint32_t, Candle>& mapPoints);
+    void SetDataPoints(std::map<uint32_t, Candle>&& mapPoints);
+    void SetDataPoints(const std::map<uint32_t, double>& mapPoints, uint32_t candleTimePeriod = 0);
+    void SetDataPoints(const std::map<uint32_t, double>& mapPoints, const std::map<uint32_t, double>& volPoints, uint32_t candleTimePeriod = 0);
+    void SetTicks(const uint32_t* pTime, const double* pPrice, const double* pVolume, size_t nCount, uint32_t candleTimePeriod = 0);
+    void AddTick(uint32_t nTime, double dPrice, double dVolume = 0);
+    void AppendCandles(const std::pair<uint32_t, Candle>* pCandles, size_t nCount);
+    void AppendCandles(const std::vector<std::pair<uint32_t, Candle>>& vCandles);
+    void SetDataView(const CandleView& view);
+    void DataViewAppended(const CandleView& view);
+    void SetModel(const std::shared_ptr<SeriesModel>& model, uint32_t candleTimePeriod = 0);
+    void SetSource(const std::shared_ptr<ChunkedSeries<Candle>>& source);
+    std::shared_ptr<Ingestor<Candle>> CreateIngestor(size_t nCapacity = 65536, IngestOverflow policy = IngestOverflow::COALESCE);
     void SetCandleBodyColor(const QColor& upColor, const QColor& downColor = QColor());
     void SetCandleLineColor(const QColor& upColor, const QColor& downColor = QColor());
     void SetTailColor(const QColor& upColor, const QColor& downColor = QColor());
@@ -147,9 +312,26 @@ public:
     void SetCandleWidth(int nWidth);
     void SetCandleWidth(int nWidth, int nMinWidth, int nMaxWidth);
     void SetCandleTimePeriod(uint32_t nTime);
+    void ScrollCandles(int nCandles);
+    void SetScrollOffset(size_t nOffset);
+    size_t ScrollOffset() const { return m_nScrollOffset; }
     void SetOLHCFont(const QFont &font);
     void SetVolumeColor(const QColor& color);
     std::vector<std::pair<QString, QColor>> GetLegendData();
+    const AnnotationLayer& Annotations() const { return m_annotations; }
+    void AddAnnotationPoint(uint32_t nTime, double dValue, const QColor& color, const QString& strText = QString());
+    void AddAnnotationRect(uint32_t nTimeFirst, uint32_t nTimeLast, double dLow, double dHigh, const QColor& color, const QString& strText = QString());
+    void AddAnnotationLabel(uint32_t nTime, double dValue, const QString& strText, const QColor& color);
+    void AddAnnotationLine(double dValue, const QColor& color, const QString& strText = QString());
+    void ClearAnnotations();
+    void SetAnnotationMarkerSize(int nSize);
+
+public slots:
+    void RefreshSource();
+
+private slots:
+    void OnModelChanged();
+    void OnModelReset();
 
 signals:
     void candleWidthChanged(int dChange);
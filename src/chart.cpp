@@ -22,14 +22,19 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 #include "chart.h"
+#include "chartgroup.h"
 #include "stringutil.h"
 
 #include <QDateTime>
 #include <QLineF>
+#include <QMouseEvent>
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPen>
 #include <QPainterPath>
+#include <QTimer>
+
+#include <cmath>
 
 /* ----------------------------------------------- |
  * |              TOP TITLE AREA                   |
@@ -64,6 +69,15 @@ Chart::Chart(QWidget *parent) : QWidget (parent)
     m_axisSections = 0;
     m_yPadding = 0;
     m_fChangesMade = true;
+    m_nUpdateDepth = 0;
+    m_fUpdatePending = false;
+    m_pTimerIngest = nullptr;
+    m_nIngestInterval = 16;
+    m_fLinkedHover = false;
+    m_dLinkedHoverX = 0;
+    m_fLinkedPanning = false;
+    m_pairLinkedPanStart = {0, 0};
+    m_lastMouseInChartArea = false;
     m_rightMargin = -1;
     m_topTitleHeight = -1;
     m_precision = 100000000;
@@ -81,6 +95,15 @@ Chart::Chart(ChartType type, QWidget* parent) : QWidget (parent)
     m_axisSections = 0;
     m_yPadding = 0;
     m_fChangesMade = true;
+    m_nUpdateDepth = 0;
+    m_fUpdatePending = false;
+    m_pTimerIngest = nullptr;
+    m_nIngestInterval = 16;
+    m_fLinkedHover = false;
+    m_dLinkedHoverX = 0;
+    m_fLinkedPanning = false;
+    m_pairLinkedPanStart = {0, 0};
+    m_lastMouseInChartArea = false;
     m_rightMargin = -1;
     m_topTitleHeight = -1;
     m_precision = 100000000;
@@ -209,19 +232,20 @@ void Chart::DrawXLabels(QPainter& painter, const std::vector<int>& vXPoints, boo
     uint32_t nMinX = MinX();
     uint32_t nMaxX = MaxX();
     uint32_t nRangeX = nMaxX - nMinX;
+
+    //Tick labels of a shared x range are the same in every member of the group, the mouse display label is not
+    std::pair<double, double> pairLinked;
+    bool fSharedLabels = fDrawIndicatorLine && LinkedXRange(pairLinked);
     for (int x : vXPoints) {
         QPointF pointDraw(x, rectXLabels.top());
         std::pair<uint32_t, double> pairPoints = ConvertFromPlotPoint(pointDraw);
         const uint32_t& nValue = pairPoints.first;
 
         QString strLabel;
-        if (m_settingsXLabels.labeltype == AxisLabelType::AX_TIMESTAMP) {
-            strLabel = TimeStampToString(nValue);
-        } else if (m_settingsXLabels.labeltype == AxisLabelType::AX_TIMESTAMP_TIME) {
-            strLabel = TimeStampToString_Hours(nValue, nRangeX, m_settingsXLabels.timeOffset);
-        } else {
-            strLabel = PrecisionToString(nValue, m_settingsXLabels.Precision());
-        }
+        if (fSharedLabels)
+            strLabel = m_pChartGroup->XLabel(nValue, nRangeX, m_settingsXLabels);
+        else
+            strLabel = XLabelString(nValue, nRangeX, m_settingsXLabels);
 
         QRect rectDraw;
         rectDraw.setTopLeft(pointDraw.toPoint());
@@ -251,6 +275,19 @@ void Chart::DrawXLabels(QPainter& painter, const std::vector<int>& vXPoints, boo
     }
 }
 
+/**
+ * @brief Chart::XLabelString: The text of an x axis label
+ * @param nRangeX: The span of the x axis, time labels show more detail for shorter spans
+ */
+QString Chart::XLabelString(uint32_t nValue, uint32_t nRangeX, const AxisLabelSettings& settings)
+{
+    if (settings.labeltype == AxisLabelType::AX_TIMESTAMP)
+        return TimeStampToString(nValue);
+    if (settings.labeltype == AxisLabelType::AX_TIMESTAMP_TIME)
+        return TimeStampToString_Hours(nValue, nRangeX, settings.timeOffset);
+    return PrecisionToString(nValue, settings.Precision());
+}
+
 void Chart::DrawYLabels(QPainter &painter, const std::vector<int> &vYPoints, bool isMouseDisplay)
 {
     QFontMetrics fm(painter.font());
@@ -307,12 +344,242 @@ bool Chart::SaveAsPng(const QString &filePath)
     return pixmap.save(QString(filePath)+QString("/chart.png"), "PNG");
 }
 
+/**
+ * @brief Chart::mousePressEvent: With a linked x axis, dragging the chart area pans every chart of the group
+ */
+void Chart::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton && XAxisLinked() && ChartArea().contains(event->pos())) {
+        m_fLinkedPanning = true;
+        m_pointLinkedPanStart = event->pos();
+        if (!LinkedXRange(m_pairLinkedPanStart))
+            m_pairLinkedPanStart = {MinX(), MaxX()};
+    }
+    QWidget::mousePressEvent(event);
+}
+
 void Chart::mouseMoveEvent(QMouseEvent *event)
 {
     QWidget::mouseMoveEvent(event);
+    if (m_fLinkedPanning && m_pChartGroup && ChartArea().width() > 0) {
+        //Dragging to the right pulls older values into view
+        double dSpan = m_pairLinkedPanStart.second - m_pairLinkedPanStart.first;
+        double dDelta = (event->pos().x() - m_pointLinkedPanStart.x()) * dSpan / ChartArea().width();
+        m_pChartGroup->SetXRange(m_pairLinkedPanStart.first - dDelta, m_pairLinkedPanStart.second - dDelta);
+    }
+    BroadcastHover(event->pos());
     repaint();
 }
 
+void Chart::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+        m_fLinkedPanning = false;
+    QWidget::mouseReleaseEvent(event);
+}
+
+/**
+ * @brief Chart::wheelEvent: With a linked x axis, the wheel zooms every chart of the group around the x under the mouse
+ */
+void Chart::wheelEvent(QWheelEvent *event)
+{
+    if (!XAxisLinked()) {
+        QWidget::wheelEvent(event);
+        return;
+    }
+    double dSteps = event->angleDelta().y() / 120.0;
+    m_pChartGroup->Zoom(this, std::pow(0.8, dSteps), ConvertFromPlotX(event->position().x()));
+    event->accept();
+}
+
+void Chart::leaveEvent(QEvent *event)
+{
+    QWidget::leaveEvent(event);
+    if (m_pChartGroup)
+        m_pChartGroup->ClearHover(this);
+}
+
+/**
+ * @brief Chart::ConvertToPlotX: convert an x value into the screen x it is painted at
+ */
+double Chart::ConvertToPlotX(double dX) const
+{
+    QRect rectChart = ChartArea();
+    double dSpan = MaxX() - MinX();
+    if (dSpan <= 0)
+        return rectChart.left();
+    return rectChart.left() + (dX - MinX()) / dSpan * rectChart.width();
+}
+
+/**
+ * @brief Chart::ConvertFromPlotX: convert a screen x into the x value that is painted there
+ */
+double Chart::ConvertFromPlotX(double x) const
+{
+    QRect rectChart = ChartArea();
+    if (rectChart.width() <= 0)
+        return MinX();
+    return MinX() + (x - rectChart.left()) / rectChart.width() * (MaxX() - MinX());
+}
+
+/**
+ * @brief Chart::LinkedHoverRegion: The area the crosshair of a linked hover at dX covers. Charts that show value
+ * readouts for the hovered x add the area of those.
+ */
+QRegion Chart::LinkedHoverRegion(double dX)
+{
+    QRegion region;
+    QRect rectChart = ChartArea();
+    int x = static_cast<int>(std::round(ConvertToPlotX(dX)));
+    region += QRect(x - 1, rectChart.top(), 3, rectChart.height());
+    if (m_settingsXLabels.fEnabled)
+        region += XLabelStripRect(x);
+    return region;
+}
+
+/**
+ * @brief Chart::XLabelStripRect: The part of the x label area that the mouse display label for x is drawn in
+ */
+QRect Chart::XLabelStripRect(int x)
+{
+    uint32_t nRangeX = static_cast<uint32_t>(MaxX()) - static_cast<uint32_t>(MinX());
+    uint32_t nValue = ConvertFromPlotPoint(QPointF(x, 0)).first;
+    QFontMetrics fm(m_settingsXLabels.font);
+    int nWidth = fm.horizontalAdvance(XLabelString(nValue, nRangeX, m_settingsXLabels)) + 4;
+    QRect rectXLabels = XLabelArea();
+    return QRect(x - nWidth / 2 - 2, rectXLabels.top(), nWidth + 4, rectXLabels.height());
+}
+
+/**
+ * @brief Chart::YLabelStripRect: The part of the y label area that the mouse display label for y is drawn in
+ */
+QRect Chart::YLabelStripRect(int y) const
+{
+    QFontMetrics fm(m_settingsYLabels.font);
+    QRect rectYLabels = YLabelArea();
+    return QRect(rectYLabels.left(), y - fm.height() / 2 - 2, rectYLabels.width(), fm.height() + 4);
+}
+
+/**
+ * @brief Chart::CrossHairRegion: The area the mouse display covers with the mouse at pos, the cross hair lines and the
+ * labels on both axes
+ */
+QRegion Chart::CrossHairRegion(const QPoint& pos)
+{
+    QRegion region;
+    QRect rectChart = ChartArea();
+    region += QRect(rectChart.left(), pos.y() - 1, rectChart.width(), 3);
+    region += QRect(pos.x() - 1, rectChart.top(), 3, rectChart.height());
+    if (m_axisSections > 0 && m_settingsYLabels.fEnabled)
+        region += YLabelStripRect(pos.y());
+    if (m_axisSections > 0 && m_settingsXLabels.fEnabled)
+        region += XLabelStripRect(pos.x());
+    return region;
+}
+
+/**
+ * @brief Chart::MoveCrossHair: Record the new mouse position
+ * @return The area that has to be repainted to move the mouse display there, empty if it is disabled or did not move
+ */
+QRegion Chart::MoveCrossHair(const QPoint& pos, bool fInChartArea)
+{
+    QRegion region;
+    if (m_mousedisplay.IsEnabled() && pos != m_lastMousePos) {
+        if (m_lastMouseInChartArea)
+            region += CrossHairRegion(m_lastMousePos);
+        if (fInChartArea)
+            region += CrossHairRegion(pos);
+    }
+    m_lastMousePos = pos;
+    m_lastMouseInChartArea = fInChartArea;
+    return region;
+}
+
+/**
+ * @brief Chart::LinkedHoverPoint: Where the crosshair of the linked hover goes in this chart, the y is the middle of the chart
+ * @return false if there is no linked hover or it is outside of the chart area
+ */
+bool Chart::LinkedHoverPoint(QPoint& point) const
+{
+    if (!m_fLinkedHover || !m_mousedisplay.IsEnabled())
+        return false;
+    QRect rectChart = ChartArea();
+    int x = static_cast<int>(std::round(ConvertToPlotX(m_dLinkedHoverX)));
+    if (x < rectChart.left() || x > rectChart.right())
+        return false;
+    point = QPoint(x, rectChart.center().y());
+    return true;
+}
+
+/**
+ * @brief Chart::BroadcastHover: Hand the x under the mouse to the other charts of the group
+ */
+void Chart::BroadcastHover(const QPoint& pos)
+{
+    if (!m_pChartGroup)
+        return;
+    if (ChartArea().contains(pos))
+        m_pChartGroup->SetHoverX(this, ConvertFromPlotX(pos.x()));
+    else
+        m_pChartGroup->ClearHover(this);
+}
+
+bool Chart::XAxisLinked() const
+{
+    return m_pChartGroup && m_pChartGroup->XAxisLinked();
+}
+
+/**
+ * @brief Chart::LinkedXRange: The x range shared by the group
+ * @return false if the chart shows its own extents
+ */
+bool Chart::LinkedXRange(std::pair<double, double>& pairRange) const
+{
+    return m_pChartGroup && m_pChartGroup->XRange(pairRange);
+}
+
+/**
+ * @brief Chart::LinkedXRangeChanged: The x range shared by the group moved, or the chart went back to its own extents.
+ * Charts that derive their x range in ProcessChangedData() redo it on the next paint.
+ */
+void Chart::LinkedXRangeChanged()
+{
+    m_fChangesMade = true;
+    update();
+}
+
+/**
+ * @brief Chart::SetLinkedHover: Show the crosshair at dX, which the mouse is over in another chart.
+ * Only the crosshair and readouts of the old and new x are repainted.
+ */
+void Chart::SetLinkedHover(double dX)
+{
+    if (m_fLinkedHover && m_dLinkedHoverX == dX)
+        return;
+
+    QRegion region;
+    if (m_fLinkedHover && m_mousedisplay.IsEnabled())
+        region += LinkedHoverRegion(m_dLinkedHoverX);
+    m_fLinkedHover = true;
+    m_dLinkedHoverX = dX;
+    if (m_mousedisplay.IsEnabled())
+        region += LinkedHoverRegion(dX);
+    if (!region.isEmpty())
+        update(region);
+}
+
+void Chart::ClearLinkedHover()
+{
+    if (!m_fLinkedHover)
+        return;
+    QRegion region;
+    if (m_mousedisplay.IsEnabled())
+        region = LinkedHoverRegion(m_dLinkedHoverX);
+    m_fLinkedHover = false;
+    if (!region.isEmpty())
+        update(region);
+}
+
 void Chart::SetBackgroundBrush(const QBrush &brush)
 {
     m_brushBackground = brush;
@@ -423,9 +690,84 @@ void Chart::SetChartType(const ChartType &type)
 {
     m_chartType = type;
     m_fChangesMade = true;
+    DataChanged();
+}
+
+/**
+ * @brief Chart::BeginUpdate: Open an update batch. Until the matching EndUpdate(), data mutators only
+ * record that something changed instead of recomputing extents and caches on every call.
+ * Batches may be nested.
+ */
+void Chart::BeginUpdate()
+{
+    m_nUpdateDepth++;
+}
+
+/**
+ * @brief Chart::EndUpdate: Close an update batch. When the outermost batch closes, any pending data changes are
+ * processed once and a single repaint is scheduled.
+ */
+void Chart::EndUpdate()
+{
+    if (m_nUpdateDepth == 0)
+        return;
+
+    m_nUpdateDepth--;
+    if (m_nUpdateDepth > 0 || !m_fUpdatePending)
+        return;
+
+    m_fUpdatePending = false;
+    ProcessChangedData();
+    update();
+}
+
+/**
+ * @brief Chart::DataChanged: Called by the data mutators. Processes the change right away, or defers it to
+ * EndUpdate() when an update batch is open.
+ */
+void Chart::DataChanged()
+{
+    if (m_nUpdateDepth > 0) {
+        m_fUpdatePending = true;
+        m_fChangesMade = true;
+        return;
+    }
     ProcessChangedData();
 }
 
+/**
+ * @brief Chart::StartIngestTimer: Start draining the chart's ingestors once per frame
+ */
+void Chart::StartIngestTimer()
+{
+    if (!m_pTimerIngest) {
+        m_pTimerIngest = new QTimer(this);
+        connect(m_pTimerIngest, &QTimer::timeout, this, &Chart::OnIngestTimer);
+    }
+    if (!m_pTimerIngest->isActive())
+        m_pTimerIngest->start(m_nIngestInterval);
+}
+
+/**
+ * @brief Chart::SetIngestInterval: Set how often queued ingestor items are moved into the chart
+ * @param nMsec: Milliseconds between two drains, defaults to 16 for one drain per frame at 60Hz
+ */
+void Chart::SetIngestInterval(int nMsec)
+{
+    m_nIngestInterval = std::max(1, nMsec);
+    if (m_pTimerIngest && m_pTimerIngest->isActive())
+        m_pTimerIngest->start(m_nIngestInterval);
+}
+
+/**
+ * @brief Chart::OnIngestTimer: Move everything that was queued since the last frame into the chart and schedule one repaint
+ */
+void Chart::OnIngestTimer()
+{
+    if (DrainIngestors())
+        update();
+}
+
 uint32_t Chart::Version()
 {
     uint32_t nVersion = 0;
@@ -31,18 +31,26 @@ SOFTWARE.
 #include <QBrush>
 #include <QPen>
 #include <QPointF>
+#include <QPointer>
+#include <QRegion>
 #include <QString>
 #include <QWidget>
 #include <QWheelEvent>
 
+#include <algorithm>
 #include <list>
+#include <map>
 #include <set>
+#include <vector>
 
 class QColor;
 class QPaintEvent;
+class QTimer;
 
 namespace PssCharts {
 
+class ChartGroup;
+
 enum class AxisLabelType
 {
     AX_NO_LABEL,
@@ -67,6 +75,7 @@ ChartType ChartTypeFromString(std::string strType);
 class Chart : public QWidget
 {
     Q_OBJECT
+    friend class ChartGroup;
 
 private:
     static const uint32_t VERSION_MAJOR = 0;
@@ -113,6 +122,21 @@ protected:
     QPixmap m_pixmapCache;
     bool m_fChangesMade; // Have changes been made since the last paint
 
+    int m_nUpdateDepth; // Nesting level of BeginUpdate()/EndUpdate()
+    bool m_fUpdatePending; // Data was changed while an update batch was open
+
+    QTimer* m_pTimerIngest; // Drains the ingestors once per frame, created with the first ingestor
+    int m_nIngestInterval; // Milliseconds between two drains
+
+    QPointer<ChartGroup> m_pChartGroup; // Group the hovered x is shared with
+    bool m_fLinkedHover; // The mouse is over another chart of the group
+    double m_dLinkedHoverX; // X value the mouse is over in the other chart
+    bool m_fLinkedPanning; // Dragging the shared x range of the group
+    QPoint m_pointLinkedPanStart;
+    std::pair<double, double> m_pairLinkedPanStart; // Shared x range when the drag started
+    QPoint m_lastMousePos; // Where the mouse display was last drawn
+    bool m_lastMouseInChartArea;
+
     int HeightTopTitleArea() const;
     int HeightXLabelArea() const;
 
@@ -121,11 +145,73 @@ protected:
     int WidthRightMargin() const;
 
     virtual void ProcessChangedData() {return;}
+    void DataChanged();
+    virtual bool DrainIngestors() {return false;}
+    void StartIngestTimer();
+
+    virtual double ConvertToPlotX(double dX) const;
+    virtual double ConvertFromPlotX(double x) const;
+    virtual QRegion LinkedHoverRegion(double dX);
+    QRect XLabelStripRect(int x);
+    QRect YLabelStripRect(int y) const;
+    QRegion CrossHairRegion(const QPoint& pos);
+    QRegion MoveCrossHair(const QPoint& pos, bool fInChartArea);
+    bool LinkedHoverPoint(QPoint& point) const;
+    void BroadcastHover(const QPoint& pos);
+    bool XAxisLinked() const;
+    bool LinkedXRange(std::pair<double, double>& pairRange) const;
+    virtual void LinkedXRangeChanged();
+    static QString XLabelString(uint32_t nValue, uint32_t nRangeX, const AxisLabelSettings& settings);
 
 public:
+    /**
+     * @brief Chart::MergeIntoMap: Insert a batch of (x, value) pairs into a map keyed by x. Input that is sorted and
+     * newer than the current tail is appended in amortized constant time per point; anything else is sorted and
+     * merged using running insertion hints. Existing keys are left untouched, the same as std::map::emplace().
+     * @return true if the input was a pure tail append
+     */
+    template <typename T>
+    static bool MergeIntoMap(std::map<uint32_t, T>& mapData, const std::pair<uint32_t, T>* pPoints, size_t nCount)
+    {
+        auto cmpKey = [](const std::pair<uint32_t, T>& a, const std::pair<uint32_t, T>& b) { return a.first < b.first; };
+        bool fTail = mapData.empty() || pPoints[0].first > mapData.rbegin()->first;
+        if (fTail && std::is_sorted(pPoints, pPoints + nCount, cmpKey)) {
+            for (size_t i = 0; i < nCount; i++)
+                mapData.emplace_hint(mapData.end(), pPoints[i].first, pPoints[i].second);
+            return true;
+        }
+
+        std::vector<std::pair<uint32_t, T>> vSorted(pPoints, pPoints + nCount);
+        std::stable_sort(vSorted.begin(), vSorted.end(), cmpKey);
+        auto itHint = mapData.lower_bound(vSorted.front().first);
+        for (const auto& pair : vSorted) {
+            itHint = mapData.emplace_hint(itHint, pair.first, pair.second);
+            ++itHint;
+        }
+        return false;
+    }
+
+    /**
+     * @brief The UpdateBatch class: RAII helper that holds a chart in an update batch for its lifetime.
+     */
+    class UpdateBatch
+    {
+    private:
+        Chart* m_pChart;
+
+    public:
+        explicit UpdateBatch(Chart* pChart) : m_pChart(pChart) { m_pChart->BeginUpdate(); }
+        ~UpdateBatch() { m_pChart->EndUpdate(); }
+        UpdateBatch(const UpdateBatch&) = delete;
+        UpdateBatch& operator=(const UpdateBatch&) = delete;
+    };
+
     Chart(QWidget* parent = nullptr);
     Chart(ChartType type, QWidget* parent = nullptr);
     bool ChangesMade() const { return m_fChangesMade; }
+    void BeginUpdate();
+    void EndUpdate();
+    bool InUpdate() const { return m_nUpdateDepth > 0; }
     void DrawXLabels(QPainter& painter, const std::vector<int>& vXPoints, bool fDrawIndicatorLine);
     void DrawYLabels(QPainter& painter, const std::vector<int>& vYPoints, bool isMouseDisplay);
     void EnableMouseDisplay(bool fEnable);
@@ -151,6 +237,7 @@ public:
     void SetAxisLabelsOnOff(bool fDrawXLabels, bool fDrawYLabels);
     void SetAxisSectionCount(uint32_t nCount);
     void SetAxisSeparatorPen(const QPen& pen);
+    void SetIngestInterval(int nMsec);
     void SetTopTitleColor(const QColor &color);
     void SetYTitleColor(const QColor &color);
     static uint32_t Version();
@@ -159,6 +246,9 @@ public:
     AxisLabelSettings* YLabelSettings() { return &m_settingsYLabels; }
     AxisLabelSettings* XLabelSettings() { return &m_settingsXLabels; }
     MouseDisplay* GetMouseDisplay() { return &m_mousedisplay; }
+    ChartGroup* Group() const { return m_pChartGroup; }
+    void SetLinkedHover(double dX);
+    void ClearLinkedHover();
 
     QRect ChartArea() const;
     QRect YLabelArea() const;
@@ -172,9 +262,14 @@ public:
 
     QPixmap grab(const QRect &rectangle = QRect(QPoint(0, 0), QSize(-1, -1)));
     bool SaveAsPng(const QString& filePath);
+    void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+    void leaveEvent(QEvent* event) override;
 
-
+private slots:
+    void OnIngestTimer();
 };
 
 } //namespace
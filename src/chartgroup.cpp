@@ -0,0 +1,297 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "chartgroup.h"
+#include "chart.h"
+#include "rangeindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace PssCharts {
+
+ChartGroup::ChartGroup(QObject* parent) : QObject(parent)
+{
+    m_fHover = false;
+    m_dHoverX = 0;
+    m_fLinkX = false;
+    m_fXRange = false;
+    m_pairXRange = {0, 0};
+}
+
+ChartGroup::~ChartGroup()
+{
+    for (Chart* pChart : Charts()) {
+        pChart->m_pChartGroup = nullptr;
+        pChart->ClearLinkedHover();
+        if (m_fXRange)
+            pChart->LinkedXRangeChanged();
+    }
+}
+
+/**
+ * @brief ChartGroup::AddChart: Link a chart to the group, taking it out of any group it was in before
+ */
+void ChartGroup::AddChart(Chart* pChart)
+{
+    if (!pChart || pChart->m_pChartGroup == this)
+        return;
+    if (pChart->m_pChartGroup)
+        pChart->m_pChartGroup->RemoveChart(pChart);
+
+    m_vCharts.emplace_back(pChart);
+    pChart->m_pChartGroup = this;
+    if (m_fHover)
+        pChart->SetLinkedHover(m_dHoverX);
+    if (m_fLinkX && m_fXRange)
+        pChart->LinkedXRangeChanged();
+}
+
+void ChartGroup::RemoveChart(Chart* pChart)
+{
+    auto it = std::find(m_vCharts.begin(), m_vCharts.end(), pChart);
+    if (it == m_vCharts.end())
+        return;
+    m_vCharts.erase(it);
+    pChart->m_pChartGroup = nullptr;
+    pChart->ClearLinkedHover();
+    if (m_pHoverSource == pChart)
+        ClearHover(pChart);
+    //Back to the chart's own extents
+    if (m_fLinkX && m_fXRange)
+        pChart->LinkedXRangeChanged();
+}
+
+/**
+ * @brief ChartGroup::Charts: The members that still exist
+ */
+std::vector<Chart*> ChartGroup::Charts() const
+{
+    std::vector<Chart*> vCharts;
+    for (const QPointer<Chart>& pChart : m_vCharts) {
+        if (pChart)
+            vCharts.emplace_back(pChart.data());
+    }
+    return vCharts;
+}
+
+/**
+ * @brief ChartGroup::SetHoverX: The mouse moved to dX over pSource, show the crosshair at dX in the other members
+ */
+void ChartGroup::SetHoverX(Chart* pSource, double dX)
+{
+    if (m_fHover && m_dHoverX == dX && m_pHoverSource == pSource)
+        return;
+
+    m_fHover = true;
+    m_dHoverX = dX;
+    m_pHoverSource = pSource;
+    for (Chart* pChart : Charts()) {
+        //The chart under the mouse draws its own crosshair
+        if (pChart == pSource)
+            pChart->ClearLinkedHover();
+        else
+            pChart->SetLinkedHover(dX);
+    }
+    emit hoverChanged(true, dX);
+}
+
+/**
+ * @brief ChartGroup::ClearHover: The mouse left pSource, remove the crosshair from the other members. Ignored if the
+ * mouse has already moved on to another member.
+ */
+void ChartGroup::ClearHover(Chart* pSource)
+{
+    if (!m_fHover || m_pHoverSource != pSource)
+        return;
+
+    m_fHover = false;
+    m_pHoverSource = nullptr;
+    for (Chart* pChart : Charts())
+        pChart->ClearLinkedHover();
+    emit hoverChanged(false, m_dHoverX);
+}
+
+/**
+ * @brief ChartGroup::LinkXAxis: Share one visible x range between the members. Unlinking hands every member back its own extents.
+ */
+void ChartGroup::LinkXAxis(bool fLink)
+{
+    if (fLink == m_fLinkX)
+        return;
+    m_fLinkX = fLink;
+    if (!fLink && m_fXRange) {
+        m_fXRange = false;
+        XRangeChanged();
+    }
+}
+
+/**
+ * @brief ChartGroup::XRange: The shared x range
+ * @return false if the x axis is not linked or no range has been set, members then show their own extents
+ */
+bool ChartGroup::XRange(std::pair<double, double>& pairRange) const
+{
+    if (!m_fLinkX || !m_fXRange)
+        return false;
+    pairRange = m_pairXRange;
+    return true;
+}
+
+/**
+ * @brief ChartGroup::XRangeTimes: The whole timestamps inside the shared x range
+ */
+void ChartGroup::XRangeTimes(uint32_t& nStart, uint32_t& nEnd) const
+{
+    const double dMaxTime = std::numeric_limits<uint32_t>::max();
+    nStart = static_cast<uint32_t>(std::max(0.0, std::min(std::ceil(m_pairXRange.first), dMaxTime)));
+    nEnd = static_cast<uint32_t>(std::max(0.0, std::min(std::floor(m_pairXRange.second), dMaxTime)));
+}
+
+/**
+ * @brief ChartGroup::SetXRange: Show [dMin, dMax] in every member. Ignored while the x axis is not linked.
+ */
+void ChartGroup::SetXRange(double dMin, double dMax)
+{
+    if (!m_fLinkX)
+        return;
+    if (dMax < dMin)
+        std::swap(dMin, dMax);
+    if (m_fXRange && m_pairXRange.first == dMin && m_pairXRange.second == dMax)
+        return;
+    m_fXRange = true;
+    m_pairXRange = {dMin, dMax};
+    XRangeChanged();
+}
+
+/**
+ * @brief ChartGroup::ResetXRange: Let every member show its own extents again, the x axis stays linked
+ */
+void ChartGroup::ResetXRange()
+{
+    if (!m_fXRange)
+        return;
+    m_fXRange = false;
+    XRangeChanged();
+}
+
+/**
+ * @brief ChartGroup::Zoom: Scale the shared x range around dCenterX, a factor below 1 zooms in. Before any range has been set
+ * the zoom starts from the extents of pSource.
+ */
+void ChartGroup::Zoom(Chart* pSource, double dFactor, double dCenterX)
+{
+    if (!m_fLinkX || dFactor <= 0)
+        return;
+    std::pair<double, double> pairRange = m_pairXRange;
+    if (!m_fXRange) {
+        if (!pSource)
+            return;
+        pairRange = {pSource->MinX(), pSource->MaxX()};
+    }
+
+    //Keep at least one second in view, timestamps are whole seconds
+    double dMin = dCenterX + (pairRange.first - dCenterX) * dFactor;
+    double dMax = dCenterX + (pairRange.second - dCenterX) * dFactor;
+    if (dMax - dMin < 1)
+        return;
+    SetXRange(dMin, dMax);
+}
+
+/**
+ * @brief ChartGroup::XRangeChanged: Drop everything derived from the old range and let the members redo their layout
+ */
+void ChartGroup::XRangeChanged()
+{
+    m_mapVisible.clear();
+    m_mapXLabels.clear();
+    for (Chart* pChart : Charts())
+        pChart->LinkedXRangeChanged();
+    emit xRangeChanged(m_pairXRange.first, m_pairXRange.second);
+}
+
+/**
+ * @brief ChartGroup::Visible: The visible part of a series, reused until the range moves or the series changes. Members showing
+ * the same model share one entry.
+ */
+const ChartGroup::VisibleSpan& ChartGroup::Visible(const SeriesIndex& index)
+{
+    VisibleSpan& span = m_mapVisible[&index];
+    if (span.nRevision == index.Revision() && span.nSize == index.Size())
+        return span;
+
+    uint32_t nStart, nEnd;
+    XRangeTimes(nStart, nEnd);
+    span.nRevision = index.Revision();
+    span.nSize = index.Size();
+    index.IndexRange(nStart, nEnd, span.nFirst, span.nLast);
+    span.fMinMax = index.MinMaxAt(span.nFirst, span.nLast, span.dMin, span.dMax);
+    return span;
+}
+
+/**
+ * @brief ChartGroup::VisibleIndexes: The index range [nFirst, nLast) of the points of a series inside the shared x range
+ * @return false if no range is set
+ */
+bool ChartGroup::VisibleIndexes(const SeriesIndex& index, size_t& nFirst, size_t& nLast)
+{
+    if (!m_fLinkX || !m_fXRange)
+        return false;
+    const VisibleSpan& span = Visible(index);
+    nFirst = span.nFirst;
+    nLast = span.nLast;
+    return true;
+}
+
+/**
+ * @brief ChartGroup::VisibleMinMax: The lowest and highest value of a series inside the shared x range
+ * @return false if no range is set or no point is inside it
+ */
+bool ChartGroup::VisibleMinMax(const SeriesIndex& index, double& dMin, double& dMax)
+{
+    if (!m_fLinkX || !m_fXRange)
+        return false;
+    const VisibleSpan& span = Visible(index);
+    if (!span.fMinMax)
+        return false;
+    dMin = span.dMin;
+    dMax = span.dMax;
+    return true;
+}
+
+/**
+ * @brief ChartGroup::XLabel: The text of an x axis tick label. Members with the same label settings share the strings, so each
+ * tick is formatted once per range instead of once per member.
+ */
+QString ChartGroup::XLabel(uint32_t nValue, uint32_t nRangeX, const AxisLabelSettings& settings)
+{
+    auto key = std::make_tuple(static_cast<int>(settings.labeltype), settings.timeOffset, settings.Precision(), nRangeX, nValue);
+    auto it = m_mapXLabels.find(key);
+    if (it == m_mapXLabels.end())
+        it = m_mapXLabels.emplace(key, Chart::XLabelString(nValue, nRangeX, settings)).first;
+    return it->second;
+}
+
+} //namespace
@@ -0,0 +1,114 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CHARTGROUP_H
+#define CHARTGROUP_H
+
+#include "axislabelsettings.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace PssCharts {
+
+class Chart;
+class SeriesIndex;
+
+/**
+ * @brief ChartGroup: Charts that show the same x axis, such as a line, candlestick and bar chart of one instrument.
+ * The x the mouse hovers over in one member is handed to every other member, which only repaints its crosshair and
+ * value readouts. With the x axis linked the members also share one visible x range, so panning or zooming one member
+ * moves all of them, and what only depends on that range is worked out once for the whole group. Members are not
+ * owned by the group.
+ */
+class ChartGroup : public QObject
+{
+    Q_OBJECT
+
+private:
+    std::vector<QPointer<Chart>> m_vCharts;
+    QPointer<Chart> m_pHoverSource; //! Member the mouse is over
+    bool m_fHover;
+    double m_dHoverX;
+
+    //! Visible part of a series for the shared x range
+    struct VisibleSpan
+    {
+        uint64_t nRevision;
+        size_t nSize;
+        size_t nFirst; //! Visible index range [nFirst, nLast)
+        size_t nLast;
+        bool fMinMax;
+        double dMin;
+        double dMax;
+    };
+
+    bool m_fLinkX; //! Members share the x range
+    bool m_fXRange; //! A range was set, until then every member shows its own extents
+    std::pair<double, double> m_pairXRange; // min, max
+    std::map<const SeriesIndex*, VisibleSpan> m_mapVisible; //! Cleared when the range moves
+    std::map<std::tuple<int, int32_t, int, uint32_t, uint32_t>, QString> m_mapXLabels; //! Cleared when the range moves
+
+    const VisibleSpan& Visible(const SeriesIndex& index);
+    void XRangeChanged();
+
+public:
+    explicit ChartGroup(QObject* parent = nullptr);
+    ~ChartGroup() override;
+
+    void AddChart(Chart* pChart);
+    void RemoveChart(Chart* pChart);
+    std::vector<Chart*> Charts() const;
+    bool Hovered() const { return m_fHover; }
+    double HoverX() const { return m_dHoverX; }
+
+    void SetHoverX(Chart* pSource, double dX);
+    void ClearHover(Chart* pSource);
+
+    void LinkXAxis(bool fLink);
+    bool XAxisLinked() const { return m_fLinkX; }
+    bool XRange(std::pair<double, double>& pairRange) const;
+    void XRangeTimes(uint32_t& nStart, uint32_t& nEnd) const;
+    void SetXRange(double dMin, double dMax);
+    void ResetXRange();
+    void Zoom(Chart* pSource, double dFactor, double dCenterX);
+
+    //Products of the shared x range, computed by the first member that asks for them
+    bool VisibleIndexes(const SeriesIndex& index, size_t& nFirst, size_t& nLast);
+    bool VisibleMinMax(const SeriesIndex& index, double& dMin, double& dMax);
+    QString XLabel(uint32_t nValue, uint32_t nRangeX, const AxisLabelSettings& settings);
+
+signals:
+    void hoverChanged(bool fHover, double dX);
+    void xRangeChanged(double dMin, double dMax);
+};
+
+} //namespace
+#endif // CHARTGROUP_H
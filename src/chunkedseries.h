@@ -0,0 +1,227 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CHUNKEDSERIES_H
+#define CHUNKEDSERIES_H
+
+#include "seriesview.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace PssCharts {
+
+/**
+ * @brief ChunkedSeries: Append-only series that a feed thread writes while other threads read it.
+ * Points live in fixed size chunks that are never moved once written. A writer fills the tail chunk past the published
+ * size and then publishes the new size with a single release store, so publishing costs only the appended points.
+ * A reader calls Pin() to get a Snapshot of the newest published version. The snapshot keeps its chunks alive and
+ * never sees later writes, so it can be read without any locking for as long as it is held.
+ *
+ * Appends that are not sorted and newer than the last point, and Assign(), copy the data into a new generation that is
+ * swapped in as a whole. Snapshots of the old generation stay valid until they are released.
+ * x values are strictly increasing, the same ordering a std::map series has.
+ */
+template <typename T>
+class ChunkedSeries
+{
+public:
+    static const size_t CHUNK_SIZE = 4096;
+
+private:
+    struct Chunk {
+        uint32_t arrX[CHUNK_SIZE];
+        T arrY[CHUNK_SIZE];
+    };
+
+    //! One continuous history. Chunks and chunk directories are only freed together with the generation.
+    struct Generation {
+        std::vector<std::unique_ptr<Chunk>> vChunks;
+        std::vector<std::unique_ptr<Chunk*[]>> vDirectories; //! Every directory that was published, newest last
+        size_t nDirectoryCapacity;
+        std::atomic<Chunk* const*> pDirectory;
+        std::atomic<size_t> nPublished;
+
+        Generation() : nDirectoryCapacity(0), pDirectory(nullptr), nPublished(0) {}
+
+        //! Writer side, called with the writer lock held
+        void Write(size_t nIndex, const uint32_t& x, const T& y)
+        {
+            size_t nChunk = nIndex / CHUNK_SIZE;
+            if (nChunk == vChunks.size()) {
+                vChunks.emplace_back(new Chunk());
+                if (vChunks.size() > nDirectoryCapacity) {
+                    //Readers may still be using the old directory, so it is retired instead of freed
+                    size_t nCapacity = std::max<size_t>(16, nDirectoryCapacity * 2);
+                    std::unique_ptr<Chunk*[]> pNew(new Chunk*[nCapacity]);
+                    for (size_t i = 0; i < vChunks.size(); i++)
+                        pNew[i] = vChunks[i].get();
+                    pDirectory.store(pNew.get(), std::memory_order_release);
+                    vDirectories.emplace_back(std::move(pNew));
+                    nDirectoryCapacity = nCapacity;
+                } else {
+                    //The slot is past the published size, no reader looks at it until the next publish
+                    vDirectories.back()[nChunk] = vChunks.back().get();
+                }
+            }
+            Chunk* pChunk = vChunks[nChunk].get();
+            pChunk->arrX[nIndex % CHUNK_SIZE] = x;
+            pChunk->arrY[nIndex % CHUNK_SIZE] = y;
+        }
+    };
+
+    std::shared_ptr<Generation> m_pGeneration;
+    std::mutex m_mutexWriter; //! Serializes writers, readers never take it
+
+    static std::shared_ptr<Generation> Build(const std::map<uint32_t, T>& mapPoints)
+    {
+        std::shared_ptr<Generation> pGeneration = std::make_shared<Generation>();
+        size_t nIndex = 0;
+        for (const auto& pair : mapPoints)
+            pGeneration->Write(nIndex++, pair.first, pair.second);
+        pGeneration->nPublished.store(nIndex, std::memory_order_release);
+        return pGeneration;
+    }
+
+public:
+    /**
+     * @brief Snapshot: A pinned, immutable version of the series
+     */
+    class Snapshot
+    {
+        std::shared_ptr<const Generation> m_pGeneration;
+        Chunk* const* m_pDirectory;
+        size_t m_nSize;
+
+    public:
+        typedef std::pair<uint32_t, T> value_type;
+        typedef ViewIterator<Snapshot> const_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        Snapshot() : m_pDirectory(nullptr), m_nSize(0) {}
+        Snapshot(const std::shared_ptr<const Generation>& pGeneration, Chunk* const* pDirectory, size_t nSize)
+            : m_pGeneration(pGeneration), m_pDirectory(pDirectory), m_nSize(nSize) {}
+
+        size_t Size() const { return m_nSize; }
+        bool Empty() const { return m_nSize == 0; }
+        uint32_t X(size_t i) const { return m_pDirectory[i / CHUNK_SIZE]->arrX[i % CHUNK_SIZE]; }
+        const T& Y(size_t i) const { return m_pDirectory[i / CHUNK_SIZE]->arrY[i % CHUNK_SIZE]; }
+        value_type At(size_t i) const { return value_type(X(i), Y(i)); }
+
+        //! Both snapshots are versions of the same history, so one extends the other
+        bool SameGeneration(const Snapshot& other) const { return m_pGeneration == other.m_pGeneration; }
+
+        //! Index of the first point with an x value that is not less than x
+        size_t LowerBound(uint32_t x) const
+        {
+            size_t nLow = 0;
+            size_t nHigh = m_nSize;
+            while (nLow < nHigh) {
+                size_t nMid = nLow + (nHigh - nLow) / 2;
+                if (X(nMid) < x)
+                    nLow = nMid + 1;
+                else
+                    nHigh = nMid;
+            }
+            return nLow;
+        }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, m_nSize); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+    };
+
+    ChunkedSeries() : m_pGeneration(std::make_shared<Generation>()) {}
+    ChunkedSeries(const ChunkedSeries&) = delete;
+    ChunkedSeries& operator=(const ChunkedSeries&) = delete;
+
+    /**
+     * @brief Pin: Snapshot of the newest published version. Safe to call from any thread while a writer appends.
+     */
+    Snapshot Pin() const
+    {
+        std::shared_ptr<const Generation> pGeneration = std::atomic_load(&m_pGeneration);
+
+        //The size is read first: the directory it was published with, or any newer one, covers every chunk it counts
+        size_t nSize = pGeneration->nPublished.load(std::memory_order_acquire);
+        Chunk* const* pDirectory = pGeneration->pDirectory.load(std::memory_order_acquire);
+        return Snapshot(pGeneration, pDirectory, nSize);
+    }
+
+    /**
+     * @brief Append: Add a batch of points and publish them as one new version.
+     * A sorted batch that is newer than the last point costs only the batch, anything else rebuilds the history.
+     */
+    void Append(const std::pair<uint32_t, T>* pPoints, size_t nCount)
+    {
+        if (nCount == 0)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutexWriter);
+        Generation& generation = *m_pGeneration;
+        size_t nSize = generation.nPublished.load(std::memory_order_relaxed);
+
+        bool fTail = nSize == 0 || pPoints[0].first > generation.vChunks[(nSize - 1) / CHUNK_SIZE]->arrX[(nSize - 1) % CHUNK_SIZE];
+        for (size_t i = 1; fTail && i < nCount; i++)
+            fTail = pPoints[i].first > pPoints[i - 1].first;
+        if (!fTail) {
+            //Copy-on-write: merge into a new generation, readers keep the old one for as long as they hold it
+            std::map<uint32_t, T> mapPoints;
+            for (size_t i = 0; i < nSize; i++) {
+                const Chunk& chunk = *generation.vChunks[i / CHUNK_SIZE];
+                mapPoints.emplace_hint(mapPoints.end(), chunk.arrX[i % CHUNK_SIZE], chunk.arrY[i % CHUNK_SIZE]);
+            }
+            for (size_t i = 0; i < nCount; i++)
+                mapPoints.emplace(pPoints[i].first, pPoints[i].second);
+            std::atomic_store(&m_pGeneration, Build(mapPoints));
+            return;
+        }
+
+        for (size_t i = 0; i < nCount; i++)
+            generation.Write(nSize + i, pPoints[i].first, pPoints[i].second);
+        generation.nPublished.store(nSize + nCount, std::memory_order_release);
+    }
+
+    void Append(const std::vector<std::pair<uint32_t, T>>& vPoints)
+    {
+        if (!vPoints.empty())
+            Append(vPoints.data(), vPoints.size());
+    }
+
+    /**
+     * @brief Assign: Replace the whole history with a new generation
+     */
+    void Assign(const std::map<uint32_t, T>& mapPoints)
+    {
+        std::lock_guard<std::mutex> lock(m_mutexWriter);
+        std::atomic_store(&m_pGeneration, Build(mapPoints));
+    }
+};
+
+} //namespace
+#endif // CHUNKEDSERIES_H
@@ -0,0 +1,434 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "csvloader.h"
+
+#include <QFile>
+
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
+
+namespace PssCharts {
+
+//! Powers of ten that are exactly representable as a double
+static const double EXACT_POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool IsDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static void SkipSpaces(const char*& p, const char* pEnd)
+{
+    while (p != pEnd && (*p == ' ' || *p == '\t' || *p == '"'))
+        ++p;
+}
+
+/**
+ * @brief ParseTimestamp: Parse an unsigned integer timestamp. A fractional part is accepted and dropped.
+ */
+static bool ParseTimestamp(const char*& p, const char* pEnd, uint32_t& nValue)
+{
+    uint64_t nParsed = 0;
+    const char* pStart = p;
+    while (p != pEnd && IsDigit(*p)) {
+        nParsed = nParsed * 10 + static_cast<uint64_t>(*p - '0');
+        if (nParsed > std::numeric_limits<uint32_t>::max())
+            return false;
+        ++p;
+    }
+    if (p == pStart)
+        return false;
+    if (p != pEnd && *p == '.') {
+        ++p;
+        while (p != pEnd && IsDigit(*p))
+            ++p;
+    }
+    nValue = static_cast<uint32_t>(nParsed);
+    return true;
+}
+
+CsvLoader::CsvLoader(QObject* parent) : QObject(parent)
+{
+    m_settings.format = Format::PRICE;
+    m_settings.delimiter = ',';
+    m_settings.nChunkSize = DEFAULT_CHUNK_SIZE;
+    m_target.nSeries = 0;
+    m_targetLoad.nSeries = 0;
+    m_fCancel = false;
+    m_fRunning = false;
+    m_nRows = 0;
+    m_nSkippedRows = 0;
+
+    //Chunks parsed on the loader thread are appended to the chart on the thread this object lives in
+    connect(this, &CsvLoader::chunkReady, this, &CsvLoader::DrainChunks, Qt::QueuedConnection);
+}
+
+CsvLoader::~CsvLoader()
+{
+    Cancel();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+/**
+ * @brief CsvLoader::ParseDouble: Parse a decimal number in the C locale.
+ * Numbers with up to 19 significant digits and a small exponent are computed exactly with one multiply or divide,
+ * anything longer falls back to the standard library.
+ * @param p: Start of the number, moved past it when parsing succeeds
+ */
+bool CsvLoader::ParseDouble(const char*& p, const char* pEnd, double& dValue)
+{
+    const char* pStart = p;
+    const char* pCursor = p;
+    bool fNegative = false;
+    if (pCursor != pEnd && (*pCursor == '-' || *pCursor == '+')) {
+        fNegative = *pCursor == '-';
+        ++pCursor;
+    }
+
+    uint64_t nMantissa = 0;
+    int nDigits = 0;
+    int nExponent = 0;
+    bool fTruncated = false;
+    bool fAnyDigit = false;
+    while (pCursor != pEnd && IsDigit(*pCursor)) {
+        if (nDigits < 19) {
+            nMantissa = nMantissa * 10 + static_cast<uint64_t>(*pCursor - '0');
+            if (nMantissa != 0)
+                nDigits++;
+        } else {
+            nExponent++;
+            fTruncated = true;
+        }
+        fAnyDigit = true;
+        ++pCursor;
+    }
+    if (pCursor != pEnd && *pCursor == '.') {
+        ++pCursor;
+        while (pCursor != pEnd && IsDigit(*pCursor)) {
+            if (nDigits < 19) {
+                nMantissa = nMantissa * 10 + static_cast<uint64_t>(*pCursor - '0');
+                if (nMantissa != 0)
+                    nDigits++;
+                nExponent--;
+            } else {
+                fTruncated = true;
+            }
+            fAnyDigit = true;
+            ++pCursor;
+        }
+    }
+    if (!fAnyDigit)
+        return false;
+
+    if (pCursor != pEnd && (*pCursor == 'e' || *pCursor == 'E')) {
+        const char* pExponent = pCursor + 1;
+        bool fNegativeExponent = false;
+        if (pExponent != pEnd && (*pExponent == '-' || *pExponent == '+')) {
+            fNegativeExponent = *pExponent == '-';
+            ++pExponent;
+        }
+        if (pExponent != pEnd && IsDigit(*pExponent)) {
+            int nExplicit = 0;
+            while (pExponent != pEnd && IsDigit(*pExponent)) {
+                if (nExplicit < 10000)
+                    nExplicit = nExplicit * 10 + (*pExponent - '0');
+                ++pExponent;
+            }
+            nExponent += fNegativeExponent ? -nExplicit : nExplicit;
+            pCursor = pExponent;
+        }
+    }
+
+    //Both the mantissa and the power of ten are exact, so a single operation rounds correctly
+    if (!fTruncated && nMantissa <= (static_cast<uint64_t>(1) << 53) && nExponent >= -22 && nExponent <= 22) {
+        double d = static_cast<double>(nMantissa);
+        d = nExponent < 0 ? d / EXACT_POW10[-nExponent] : d * EXACT_POW10[nExponent];
+        dValue = fNegative ? -d : d;
+        p = pCursor;
+        return true;
+    }
+
+    std::istringstream stream(std::string(pStart, pCursor));
+    stream.imbue(std::locale::classic());
+    double d = 0;
+    if (!(stream >> d))
+        return false;
+    dValue = d;
+    p = pCursor;
+    return true;
+}
+
+/**
+ * @brief CsvLoader::ParseLine: Parse one row into the chunk
+ * @return false if the row does not match the format
+ */
+bool CsvLoader::ParseLine(const CsvSettings& settings, const char* pBegin, const char* pEnd, CsvChunk& chunk)
+{
+    const size_t nRequired = settings.format == Format::OHLC ? 5 : 2;
+    double arrValues[6] = {0};
+    uint32_t nTime = 0;
+    size_t nFields = 0;
+
+    const char* p = pBegin;
+    while (p != pEnd && nFields < nRequired + 1) {
+        SkipSpaces(p, pEnd);
+        bool fParsed = nFields == 0 ? ParseTimestamp(p, pEnd, nTime) : ParseDouble(p, pEnd, arrValues[nFields - 1]);
+        if (!fParsed)
+            break;
+        SkipSpaces(p, pEnd);
+        nFields++;
+        if (p == pEnd || *p != settings.delimiter)
+            break;
+        ++p;
+    }
+    if (nFields < nRequired)
+        return false;
+
+    bool fVolume = nFields > nRequired;
+    if (settings.format == Format::PRICE) {
+        chunk.vPoints.emplace_back(nTime, arrValues[0]);
+        if (fVolume)
+            chunk.vVolume.emplace_back(nTime, arrValues[1]);
+        return true;
+    }
+
+    //Rows are not trusted, so check them here instead of letting the Candle constructor throw
+    Candle candle;
+    candle.m_open = arrValues[0];
+    candle.m_high = arrValues[1];
+    candle.m_low = arrValues[2];
+    candle.m_close = arrValues[3];
+    candle.m_volume = fVolume ? arrValues[4] : 0;
+    if (candle.m_high < std::max(candle.m_open, std::max(candle.m_low, candle.m_close)))
+        return false;
+    if (candle.m_low > std::min(candle.m_open, std::min(candle.m_high, candle.m_close)))
+        return false;
+    chunk.vCandles.emplace_back(nTime, candle);
+    return true;
+}
+
+/**
+ * @brief CsvLoader::ParseBuffer: Parse every complete line in a buffer
+ * @param fFinal: The buffer ends the file, so a last line without a line break is parsed too
+ * @return Number of bytes consumed, the rest is an incomplete line that has to be carried into the next buffer
+ */
+size_t CsvLoader::ParseBuffer(const CsvSettings& settings, const char* pBegin, const char* pEnd, bool fFinal, CsvChunk& chunk)
+{
+    uint64_t nRows = 0;
+    uint64_t nSkipped = 0;
+    const char* p = pBegin;
+    while (p != pEnd) {
+        //memchr is vectorized by the C library, which makes the line scan the cheap part of parsing
+        const char* pLineEnd = static_cast<const char*>(memchr(p, '\n', pEnd - p));
+        if (!pLineEnd && !fFinal)
+            break;
+        const char* pNext = pLineEnd ? pLineEnd + 1 : pEnd;
+        if (!pLineEnd)
+            pLineEnd = pEnd;
+        if (pLineEnd != p && *(pLineEnd - 1) == '\r')
+            --pLineEnd;
+        if (pLineEnd != p) {
+            if (ParseLine(settings, p, pLineEnd, chunk))
+                nRows++;
+            else
+                nSkipped++;
+        }
+        p = pNext;
+    }
+    m_nRows += nRows;
+    m_nSkippedRows += nSkipped;
+    return p - pBegin;
+}
+
+/**
+ * @brief CsvLoader::ReadFile: Read and parse the file chunk by chunk, handing each parsed chunk to fnChunk
+ */
+bool CsvLoader::ReadFile(const CsvSettings& settings, const QString& strPath, const std::function<void(CsvChunk&)>& fnChunk)
+{
+    QFile file(strPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 nTotal = file.size();
+    qint64 nBytesRead = 0;
+    std::vector<char> vBuffer;
+    size_t nCarry = 0;
+    while (!m_fCancel) {
+        vBuffer.resize(nCarry + settings.nChunkSize);
+        qint64 nRead = file.read(vBuffer.data() + nCarry, static_cast<qint64>(settings.nChunkSize));
+        if (nRead < 0)
+            return false;
+        nBytesRead += nRead;
+        size_t nFill = nCarry + static_cast<size_t>(nRead);
+        bool fFinal = nRead == 0 || file.atEnd();
+
+        CsvChunk chunk;
+        size_t nUsed = ParseBuffer(settings, vBuffer.data(), vBuffer.data() + nFill, fFinal, chunk);
+        nCarry = nFill - nUsed;
+        if (nCarry > 0)
+            memmove(vBuffer.data(), vBuffer.data() + nUsed, nCarry);
+
+        fnChunk(chunk);
+        emit progress(nBytesRead, nTotal);
+        if (fFinal)
+            break;
+    }
+    return !m_fCancel;
+}
+
+/**
+ * @brief CsvLoader::Deliver: Append a parsed chunk to the target charts. Sorted rows take the charts' tail fast path.
+ */
+void CsvLoader::Deliver(const CsvChunk& chunk)
+{
+    const CsvTarget& target = m_targetLoad;
+    if (target.pLineChart) {
+        if (!chunk.vPoints.empty())
+            target.pLineChart->AppendDataPoints(target.nSeries, chunk.vPoints);
+        if (!chunk.vVolume.empty())
+            target.pLineChart->AppendVolumePoints(target.nSeries, chunk.vVolume.data(), chunk.vVolume.size());
+        target.pLineChart->update();
+    }
+    if (target.pCandleChart) {
+        target.pCandleChart->AppendCandles(chunk.vCandles);
+        target.pCandleChart->update();
+    }
+}
+
+void CsvLoader::DrainChunks()
+{
+    std::deque<CsvChunk> dequeChunks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutexChunks);
+        dequeChunks.swap(m_dequeChunks);
+    }
+    m_condChunks.notify_all();
+    for (const CsvChunk& chunk : dequeChunks)
+        Deliver(chunk);
+}
+
+/**
+ * @brief CsvLoader::SetTarget: Append PRICE rows to a line series, and their volume to the series' volume bars
+ */
+void CsvLoader::SetTarget(LineChart* pChart, uint32_t nSeries)
+{
+    m_target.pLineChart = pChart;
+    m_target.nSeries = nSeries;
+}
+
+/**
+ * @brief CsvLoader::SetTarget: Append OHLC rows to a candlestick chart
+ */
+void CsvLoader::SetTarget(CandlestickChart* pChart)
+{
+    m_target.pCandleChart = pChart;
+}
+
+/**
+ * @brief CsvLoader::StartLoad: Fix the target for the load that is starting. A line series that does not exist yet is
+ * created, the same as SetDataPoints() would, since appending only adds to existing series.
+ */
+void CsvLoader::StartLoad()
+{
+    m_fCancel = false;
+    m_nRows = 0;
+    m_nSkippedRows = 0;
+    m_targetLoad = m_target;
+    LineChart* pLineChart = m_targetLoad.pLineChart;
+    if (pLineChart && static_cast<uint32_t>(pLineChart->SeriesCount()) < m_targetLoad.nSeries + 1)
+        pLineChart->SetDataPoints(std::map<uint32_t, double>(), m_targetLoad.nSeries);
+}
+
+/**
+ * @brief CsvLoader::Load: Load a file on the calling thread
+ * @return false if the file could not be read, the load was cancelled or a background load is running
+ */
+bool CsvLoader::Load(const QString& strPath)
+{
+    if (m_fRunning)
+        return false;
+    StartLoad();
+    bool fSuccess = ReadFile(m_settings, strPath, [this](CsvChunk& chunk) {
+        Deliver(chunk);
+    });
+    emit finished(fSuccess);
+    return fSuccess;
+}
+
+/**
+ * @brief CsvLoader::LoadAsync: Parse a file on a background thread. Parsed chunks are appended to the target charts
+ * on the thread this loader lives in, progress() reports the bytes read and finished() is emitted after the last chunk.
+ * @return false if a load is already running
+ */
+bool CsvLoader::LoadAsync(const QString& strPath)
+{
+    if (m_fRunning)
+        return false;
+    if (m_thread.joinable())
+        m_thread.join();
+    //Chunks of the previous load still go to its own target
+    DrainChunks();
+
+    StartLoad();
+    m_fRunning = true;
+    CsvSettings settings = m_settings;
+    m_thread = std::thread([this, settings, strPath]() {
+        bool fSuccess = ReadFile(settings, strPath, [this](CsvChunk& chunk) {
+            {
+                //Wait for the GUI thread to catch up, so a slow consumer does not end up with the whole file in memory
+                std::unique_lock<std::mutex> lock(m_mutexChunks);
+                m_condChunks.wait(lock, [this]() { return m_dequeChunks.size() < MAX_PENDING_CHUNKS || m_fCancel; });
+                if (m_fCancel)
+                    return;
+                m_dequeChunks.emplace_back(std::move(chunk));
+            }
+            emit chunkReady();
+        });
+        m_fRunning = false;
+        emit finished(fSuccess);
+    });
+    return true;
+}
+
+/**
+ * @brief CsvLoader::Cancel: Stop a running load after the chunk that is being parsed, or while it waits for room to queue one
+ */
+void CsvLoader::Cancel()
+{
+    {
+        //Set under the lock, so a loader thread that is about to wait for room can not miss the wake up
+        std::lock_guard<std::mutex> lock(m_mutexChunks);
+        m_fCancel = true;
+    }
+    m_condChunks.notify_all();
+}
+
+} //namespace
@@ -0,0 +1,138 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef CSVLOADER_H
+#define CSVLOADER_H
+
+#include "candlestickchart.h"
+#include "linechart.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PssCharts {
+
+/**
+ * @brief CsvLoader: Streams a CSV export into a chart through the bulk append path.
+ * The file is read in chunks, each chunk is parsed with a locale independent number parser and appended to the
+ * target chart before the next one is read, so memory use is bounded by the chunk size rather than the file size.
+ * A background load stops reading while MAX_PENDING_CHUNKS parsed chunks are waiting for the GUI thread.
+ * Rows that do not parse, such as a header line, are skipped and counted.
+ *
+ * PRICE rows are: timestamp, price[, volume]
+ * OHLC rows are: timestamp, open, high, low, close[, volume]
+ */
+class CsvLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class Format
+    {
+        PRICE,
+        OHLC
+    };
+
+    static const size_t DEFAULT_CHUNK_SIZE = 4 << 20;
+    static const size_t MAX_PENDING_CHUNKS = 4;
+
+private:
+    struct CsvChunk {
+        std::vector<std::pair<uint32_t, double>> vPoints;
+        std::vector<std::pair<uint32_t, double>> vVolume;
+        std::vector<std::pair<uint32_t, Candle>> vCandles;
+    };
+
+    //! How rows are parsed, copied into a load when it starts so that the setters can not change it halfway
+    struct CsvSettings {
+        Format format;
+        char delimiter;
+        size_t nChunkSize;
+    };
+
+    //! Where parsed rows go, only used on the thread the loader lives in
+    struct CsvTarget {
+        QPointer<LineChart> pLineChart;
+        uint32_t nSeries;
+        QPointer<CandlestickChart> pCandleChart;
+    };
+
+    CsvSettings m_settings;
+    CsvTarget m_target;
+    CsvTarget m_targetLoad; //! Target of the running or last load
+
+    std::thread m_thread;
+    std::atomic<bool> m_fCancel;
+    std::atomic<bool> m_fRunning;
+    std::atomic<uint64_t> m_nRows;
+    std::atomic<uint64_t> m_nSkippedRows;
+    std::mutex m_mutexChunks;
+    std::condition_variable m_condChunks; //! Wakes the loader thread when chunks were taken or the load was cancelled
+    std::deque<CsvChunk> m_dequeChunks; //! Parsed on the loader thread, waiting to be appended on the GUI thread
+
+    static bool ParseLine(const CsvSettings& settings, const char* pBegin, const char* pEnd, CsvChunk& chunk);
+    size_t ParseBuffer(const CsvSettings& settings, const char* pBegin, const char* pEnd, bool fFinal, CsvChunk& chunk);
+    bool ReadFile(const CsvSettings& settings, const QString& strPath, const std::function<void(CsvChunk&)>& fnChunk);
+    void StartLoad();
+    void Deliver(const CsvChunk& chunk);
+
+private slots:
+    void DrainChunks();
+
+signals:
+    void chunkReady();
+    void progress(qint64 nBytesRead, qint64 nBytesTotal);
+    void finished(bool fSuccess);
+
+public:
+    CsvLoader(QObject* parent = nullptr);
+    ~CsvLoader();
+
+    void SetFormat(Format format) { m_settings.format = format; }
+    void SetDelimiter(char delimiter) { m_settings.delimiter = delimiter; }
+    void SetChunkSize(size_t nBytes) { m_settings.nChunkSize = nBytes > 0 ? nBytes : DEFAULT_CHUNK_SIZE; }
+    void SetTarget(LineChart* pChart, uint32_t nSeries);
+    void SetTarget(CandlestickChart* pChart);
+
+    bool Load(const QString& strPath);
+    bool LoadAsync(const QString& strPath);
+    void Cancel();
+    bool IsRunning() const { return m_fRunning; }
+    uint64_t RowsLoaded() const { return m_nRows; }
+    uint64_t RowsSkipped() const { return m_nSkippedRows; }
+
+    static bool ParseDouble(const char*& p, const char* pEnd, double& dValue);
+};
+
+} //namespace
+#endif // CSVLOADER_H
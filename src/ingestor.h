@@ -0,0 +1,231 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef INGESTOR_H
+#define INGESTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace PssCharts {
+
+//! What Ingestor::Push() does when the queue is full
+enum class IngestOverflow
+{
+    REJECT, //! Drop the new item and return false, so the producer can back off
+    DROP_OLDEST, //! Discard the oldest queued item to make room for the new one
+    COALESCE //! Hold back one item, replacing it while newer items keep its timestamp
+};
+
+/**
+ * @brief Ingestor: Bounded lock-free queue that carries (x, value) items from one feed thread to a chart.
+ * Push() is only called by the feed thread and never blocks. The chart drains the queue on the GUI thread once per frame
+ * and hands the items to its bulk append path.
+ *
+ * Each slot carries a sequence number that says whether it is free or holds an item, which lets the producer discard the
+ * oldest item on overflow without racing the consumer. Items have to be copyable.
+ */
+template <typename T>
+class Ingestor
+{
+public:
+    typedef std::pair<uint32_t, T> Item;
+
+private:
+    static const size_t CACHE_LINE = 64;
+
+    struct Slot {
+        std::atomic<size_t> nSequence;
+        Item item;
+    };
+
+    std::unique_ptr<Slot[]> m_pSlots;
+    size_t m_nMask;
+    IngestOverflow m_policy;
+
+    //The two indexes are kept on separate cache lines with padding instead of alignas, since before C++17 new and
+    //make_shared do not honour an alignment above that of max_align_t
+    char m_padBeforeHead[CACHE_LINE];
+    //Read and written by both sides
+    std::atomic<size_t> m_nHead;
+    char m_padBeforeTail[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    //Written by the producer only
+    std::atomic<size_t> m_nTail;
+    char m_padAfterTail[CACHE_LINE - sizeof(std::atomic<size_t>)];
+    std::atomic<uint64_t> m_nPushed;
+    std::atomic<uint64_t> m_nDropped;
+    std::atomic<uint64_t> m_nCoalesced;
+    //Producer side state for IngestOverflow::COALESCE
+    bool m_fHeld;
+    Item m_itemHeld;
+
+    bool TryEnqueue(const Item& item)
+    {
+        size_t nPos = m_nTail.load(std::memory_order_relaxed);
+        Slot& slot = m_pSlots[nPos & m_nMask];
+        if (slot.nSequence.load(std::memory_order_acquire) != nPos)
+            return false;
+        slot.item = item;
+        slot.nSequence.store(nPos + 1, std::memory_order_release);
+        m_nTail.store(nPos + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! Producer side, frees the oldest slot unless the consumer is taking it at the same time
+    bool TryDiscardOldest()
+    {
+        size_t nPos = m_nHead.load(std::memory_order_relaxed);
+        Slot& slot = m_pSlots[nPos & m_nMask];
+        if (slot.nSequence.load(std::memory_order_acquire) != nPos + 1)
+            return false;
+        if (!m_nHead.compare_exchange_strong(nPos, nPos + 1, std::memory_order_relaxed))
+            return false;
+        slot.nSequence.store(nPos + m_nMask + 1, std::memory_order_release);
+        return true;
+    }
+
+public:
+    /**
+     * @param nCapacity: Number of queued items, rounded up to a power of two
+     */
+    explicit Ingestor(size_t nCapacity = 65536, IngestOverflow policy = IngestOverflow::DROP_OLDEST)
+        : m_policy(policy), m_nHead(0), m_nTail(0), m_nPushed(0), m_nDropped(0), m_nCoalesced(0), m_fHeld(false)
+    {
+        size_t nSize = 2;
+        while (nSize < nCapacity)
+            nSize *= 2;
+        m_pSlots.reset(new Slot[nSize]);
+        for (size_t i = 0; i < nSize; i++)
+            m_pSlots[i].nSequence.store(i, std::memory_order_relaxed);
+        m_nMask = nSize - 1;
+    }
+    Ingestor(const Ingestor&) = delete;
+    Ingestor& operator=(const Ingestor&) = delete;
+
+    /**
+     * @brief Ingestor::Push: Queue an item. Producer thread only.
+     * @return false if the item was dropped
+     */
+    bool Push(uint32_t x, const T& value)
+    {
+        m_nPushed.fetch_add(1, std::memory_order_relaxed);
+        Item item(x, value);
+
+        //A held back item goes first so that the order is kept
+        if (m_fHeld && TryEnqueue(m_itemHeld))
+            m_fHeld = false;
+        if (!m_fHeld && TryEnqueue(item))
+            return true;
+
+        switch (m_policy) {
+        case IngestOverflow::REJECT:
+            break;
+        case IngestOverflow::DROP_OLDEST:
+            if (TryDiscardOldest()) {
+                m_nDropped.fetch_add(1, std::memory_order_relaxed);
+                if (TryEnqueue(item))
+                    return true;
+            }
+            break;
+        case IngestOverflow::COALESCE:
+            if (m_fHeld && m_itemHeld.first == x)
+                m_nCoalesced.fetch_add(1, std::memory_order_relaxed);
+            else if (m_fHeld)
+                m_nDropped.fetch_add(1, std::memory_order_relaxed);
+            m_itemHeld = item;
+            m_fHeld = true;
+            return true;
+        }
+        m_nDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * @brief Ingestor::Flush: Queue the item held back by IngestOverflow::COALESCE once there is room. Producer thread only,
+     * for when the feed goes quiet after an overflow.
+     * @return false if the item is still held back
+     */
+    bool Flush()
+    {
+        if (m_fHeld && TryEnqueue(m_itemHeld))
+            m_fHeld = false;
+        return !m_fHeld;
+    }
+
+    /**
+     * @brief Ingestor::Drain: Move up to nMax queued items to the end of vItems. Consumer thread only.
+     * Consecutive items with the same x are coalesced to the latest one, since a chart keeps one value per x.
+     * @return Number of items added to vItems
+     */
+    size_t Drain(std::vector<Item>& vItems, size_t nMax = SIZE_MAX)
+    {
+        size_t nPos = m_nHead.load(std::memory_order_relaxed);
+        size_t nCount = 0;
+        while (true) {
+            //Claim every published slot at once, the producer may have discarded some in the meantime
+            nCount = 0;
+            while (nCount < nMax && m_pSlots[(nPos + nCount) & m_nMask].nSequence.load(std::memory_order_acquire) == nPos + nCount + 1)
+                nCount++;
+            if (nCount == 0)
+                return 0;
+            if (m_nHead.compare_exchange_weak(nPos, nPos + nCount, std::memory_order_relaxed))
+                break;
+        }
+
+        size_t nSizeBefore = vItems.size();
+        uint64_t nCoalesced = 0;
+        for (size_t i = 0; i < nCount; i++) {
+            Slot& slot = m_pSlots[(nPos + i) & m_nMask];
+            if (vItems.size() > nSizeBefore && vItems.back().first == slot.item.first) {
+                vItems.back().second = slot.item.second;
+                nCoalesced++;
+            } else {
+                vItems.push_back(slot.item);
+            }
+            slot.nSequence.store(nPos + i + m_nMask + 1, std::memory_order_release);
+        }
+        if (nCoalesced)
+            m_nCoalesced.fetch_add(nCoalesced, std::memory_order_relaxed);
+        return vItems.size() - nSizeBefore;
+    }
+
+    size_t Capacity() const { return m_nMask + 1; }
+    IngestOverflow Policy() const { return m_policy; }
+
+    //! Items waiting to be drained, approximate while the other side is running
+    size_t Queued() const
+    {
+        size_t nHead = m_nHead.load(std::memory_order_relaxed);
+        size_t nTail = m_nTail.load(std::memory_order_relaxed);
+        return nTail > nHead ? nTail - nHead : 0;
+    }
+    uint64_t Pushed() const { return m_nPushed.load(std::memory_order_relaxed); }
+    uint64_t Dropped() const { return m_nDropped.load(std::memory_order_relaxed); }
+    uint64_t Coalesced() const { return m_nCoalesced.load(std::memory_order_relaxed); }
+};
+
+} //namespace
+#endif // INGESTOR_H
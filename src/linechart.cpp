@@ -23,6 +23,8 @@ SOFTWARE.
 */
 
 #include "linechart.h"
+#include "chartgroup.h"
+#include "seriesmodel.h"
 #include "stringutil.h"
 
 #include <QDateTime>
@@ -34,6 +36,8 @@ SOFTWARE.
 #include <QMouseEvent>
 #include <QResizeEvent>
 
+#include <cmath>
+
 /* ----------------------------------------------- |
  * |              TOP TITLE AREA                   |
  * |             ______________________________    |
@@ -57,6 +61,161 @@ SOFTWARE.
 */
 namespace PssCharts {
 
+/**
+ * @brief ForEachPoint: Call fn with every (x, y) point of a series, whether the chart owns the points or reads them through a view
+ */
+template <typename Fn>
+static void ForEachPoint(const LineSeries& series, Fn fn)
+{
+    if (series.model)
+        std::for_each(series.model->Points().begin(), series.model->Points().end(), fn);
+    else if (series.source)
+        std::for_each(series.snapshot.begin(), series.snapshot.end(), fn);
+    else if (series.fExternal)
+        std::for_each(series.view.begin(), series.view.end(), fn);
+    else
+        std::for_each(series.data.begin(), series.data.end(), fn);
+}
+
+/**
+ * @brief ForEachIndexedIn: Call fn with the points of a view or snapshot with an x in [nStart, nEnd]. With fNeighbours the
+ * point on either side of that range is included too, so that the line runs off the edges of the chart.
+ */
+template <typename Indexed, typename Fn>
+static void ForEachIndexedIn(const Indexed& points, uint32_t nStart, uint32_t nEnd, bool fNeighbours, Fn fn)
+{
+    size_t nFirst = points.LowerBound(nStart);
+    size_t nLast = nEnd < std::numeric_limits<uint32_t>::max() ? points.LowerBound(nEnd + 1) : points.Size();
+    if (fNeighbours) {
+        nFirst = nFirst > 0 ? nFirst - 1 : 0;
+        nLast = std::min(nLast + 1, points.Size());
+    }
+    for (size_t i = nFirst; i < nLast; i++)
+        fn(std::make_pair(points.X(i), points.Y(i)));
+}
+
+template <typename Fn>
+static void ForEachMapIn(const std::map<uint32_t, double>& mapPoints, uint32_t nStart, uint32_t nEnd, bool fNeighbours, Fn fn)
+{
+    auto itFirst = mapPoints.lower_bound(nStart);
+    auto itLast = mapPoints.upper_bound(nEnd);
+    if (fNeighbours && itFirst != mapPoints.begin())
+        --itFirst;
+    if (fNeighbours && itLast != mapPoints.end())
+        ++itLast;
+    std::for_each(itFirst, itLast, fn);
+}
+
+/**
+ * @brief ForEachPointIn: ForEachPoint limited to the points with an x in [nStart, nEnd], and with fNeighbours one more
+ * point on each side
+ */
+template <typename Fn>
+static void ForEachPointIn(const LineSeries& series, uint32_t nStart, uint32_t nEnd, bool fNeighbours, Fn fn)
+{
+    if (series.model)
+        ForEachMapIn(series.model->Points(), nStart, nEnd, fNeighbours, fn);
+    else if (series.source)
+        ForEachIndexedIn(series.snapshot, nStart, nEnd, fNeighbours, fn);
+    else if (series.fExternal)
+        ForEachIndexedIn(series.view, nStart, nEnd, fNeighbours, fn);
+    else
+        ForEachMapIn(series.data, nStart, nEnd, fNeighbours, fn);
+}
+
+static size_t SeriesSize(const LineSeries& series)
+{
+    if (series.model)
+        return series.model->Points().size();
+    if (series.source)
+        return series.snapshot.Size();
+    return series.fExternal ? series.view.Size() : series.data.size();
+}
+
+static double LastValue(const LineSeries& series)
+{
+    if (series.model)
+        return series.model->Points().rbegin()->second;
+    if (series.source)
+        return series.snapshot.Y(series.snapshot.Size() - 1);
+    return series.fExternal ? series.view.Y(series.view.Size() - 1) : series.data.rbegin()->second;
+}
+
+//! The last point at or before an x and the first point at or after it
+struct PointsAround {
+    bool fBefore = false;
+    bool fAfter = false;
+    std::pair<uint32_t, double> pairBefore;
+    std::pair<uint32_t, double> pairAfter;
+};
+
+template <typename Indexed>
+static void FindPointsAround(const Indexed& points, double x, PointsAround& around)
+{
+    size_t nIndex = points.LowerBound(static_cast<uint32_t>(std::ceil(x)));
+    if (nIndex < points.Size()) {
+        around.fAfter = true;
+        around.pairAfter = std::make_pair(points.X(nIndex), points.Y(nIndex));
+        if (points.X(nIndex) == x) {
+            around.fBefore = true;
+            around.pairBefore = around.pairAfter;
+            return;
+        }
+    }
+    if (nIndex > 0) {
+        around.fBefore = true;
+        around.pairBefore = std::make_pair(points.X(nIndex - 1), points.Y(nIndex - 1));
+    }
+}
+
+static void FindPointsAround(const std::map<uint32_t, double>& mapPoints, double x, PointsAround& around)
+{
+    auto it = mapPoints.lower_bound(static_cast<uint32_t>(std::ceil(x)));
+    if (it != mapPoints.end()) {
+        around.fAfter = true;
+        around.pairAfter = *it;
+        if (it->first == x) {
+            around.fBefore = true;
+            around.pairBefore = *it;
+            return;
+        }
+    }
+    if (it != mapPoints.begin()) {
+        around.fBefore = true;
+        around.pairBefore = *std::prev(it);
+    }
+}
+
+/**
+ * @brief FindPointsAround: Binary search a series of any storage for the points on either side of x
+ */
+static PointsAround FindPointsAround(const LineSeries& series, double x)
+{
+    PointsAround around;
+    double dSearch = std::max(0.0, std::min<double>(x, std::numeric_limits<uint32_t>::max()));
+    if (series.model)
+        FindPointsAround(series.model->Points(), dSearch, around);
+    else if (series.source)
+        FindPointsAround(series.snapshot, dSearch, around);
+    else if (series.fExternal)
+        FindPointsAround(series.view, dSearch, around);
+    else
+        FindPointsAround(series.data, dSearch, around);
+
+    //Clamping must not turn an x outside of the x domain into an exact hit on the first or last point
+    if (x < dSearch)
+        around.fBefore = false;
+    else if (x > dSearch)
+        around.fAfter = false;
+    return around;
+}
+
+//! Series backed by a view, a shared model or a concurrent source can not be edited through the chart
+static bool OwnsData(const LineSeries& series)
+{
+    return !series.fExternal && !series.model && !series.source;
+}
+
 LineChart::LineChart(QWidget *parent) : Chart(ChartType::LINE, parent)
 {
     setAutoFillBackground(true);
@@ -71,15 +230,16 @@ LineChart::LineChart(QWidget *parent) : Chart(ChartType::LINE, parent)
     m_topTitleHeight = -1;
     m_precision = 100000000;
     m_nYSectionModulus = 0;
-    m_fPlotPointsDirty = true;
+    m_pairXDataRange = {0, 0};
+    m_pairYDataRange = {0, 0};
+    m_pairYScaledRange = {0, 0};
+    m_fHaveDataRange = false;
+    m_dXHeadroom = 0;
+    m_dYHeadroom = 0;
 
     m_fDrawVolume = false;
     m_nBarWidth = 5;
     
-    // Initialize mouse tracking variables
-    m_lastMouseInChartArea = false;
-    m_lastMousePos = QPoint(0, 0);
-
     setMouseTracking(true);
 }
 
@@ -214,12 +374,9 @@ std::pair<uint32_t, double> LineChart::ConvertFromPlotPoint(const QPointF& point
  */
 void LineChart::AddDataPoint(const uint32_t& nSeries, const uint32_t& x, const double& y)
 {
-    if (m_vSeries.size() < nSeries+1) {
-        //Series does not exist
-        return;
-    }
-    m_vSeries.at(nSeries).data.emplace(x, y);
-    ProcessChangedData();
+    //A single point is a batch of one, so it gets the same incremental handling
+    std::pair<uint32_t, double> pair(x, y);
+    AppendDataPoints(nSeries, &pair, 1);
 }
 
 /**
@@ -229,12 +386,13 @@ void LineChart::AddDataPoint(const uint32_t& nSeries, const uint32_t& x, const d
  */
 void LineChart::RemoveDataPoint(const uint32_t& nSeries, const uint32_t &x)
 {
-    if (m_vSeries.size() < nSeries+1) {
-        //Series does not exist
+    if (m_vSeries.size() < nSeries+1 || !OwnsData(m_vSeries.at(nSeries))) {
+        //Series does not exist, or its points are owned by someone else
         return;
     }
     m_vSeries.at(nSeries).data.erase(x);
-    ProcessChangedData();
+    MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+    DataChanged();
 }
 
 /**
@@ -243,14 +401,404 @@ void LineChart::RemoveDataPoint(const uint32_t& nSeries, const uint32_t &x)
  * @param nSeries : The index of the series that is being changed or added.
  */
 void LineChart::SetDataPoints(const std::map<uint32_t, double>& mapPoints, const uint32_t& nSeries)
+{
+    SetDataPoints(std::map<uint32_t, double>(mapPoints), nSeries);
+}
+
+/**
+ * @brief LineChart::SetDataPoints : Set the datapoints of a specific line series, taking ownership of the map without copying it.
+ * @param mapPoints
+ * @param nSeries : The index of the series that is being changed or added.
+ */
+void LineChart::SetDataPoints(std::map<uint32_t, double>&& mapPoints, const uint32_t& nSeries)
 {
     if (m_vSeries.size() < nSeries+1) {
         //Series does not exist yet
         m_vSeries.resize(nSeries+1);
         m_vSeries.at(nSeries).fShow = true;
     }
-    m_vSeries.at(nSeries).data = mapPoints;
-    ProcessChangedData();
+    ReleaseModel(nSeries);
+    LineSeries& series = m_vSeries.at(nSeries);
+    series.data = std::move(mapPoints);
+    series.view = LineView();
+    series.fExternal = false;
+    series.source.reset();
+    series.snapshot = ChunkedSeries<double>::Snapshot();
+    MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+    DataChanged();
+}
+
+/**
+ * @brief LineChart::SetDataView : Draw a line series straight from caller owned arrays instead of copying them into the chart.
+ * The caller must keep the memory alive until the series is removed or given new data. Any data the series owned is released.
+ * @param view : Points with strictly increasing x values
+ * @param nSeries : The index of the series that is being changed or added.
+ */
+void LineChart::SetDataView(const LineView& view, const uint32_t& nSeries)
+{
+    if (m_vSeries.size() < nSeries+1) {
+        //Series does not exist yet
+        m_vSeries.resize(nSeries+1);
+        m_vSeries.at(nSeries).fShow = true;
+    }
+    ReleaseModel(nSeries);
+    LineSeries& series = m_vSeries.at(nSeries);
+    std::map<uint32_t, double>().swap(series.data);
+    series.view = view;
+    series.fExternal = true;
+    series.source.reset();
+    series.snapshot = ChunkedSeries<double>::Snapshot();
+    MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+    DataChanged();
+}
+
+/**
+ * @brief LineChart::SetSeriesModel : Show a shared SeriesModel as a line series. The chart keeps a reference to the model,
+ * follows its change notifications and takes the series' extents from the model instead of scanning the points.
+ * @param model
+ * @param nSeries : The index of the series that is being changed or added.
+ */
+void LineChart::SetSeriesModel(const std::shared_ptr<SeriesModel>& model, const uint32_t& nSeries)
+{
+    if (!model)
+        return;
+    if (m_vSeries.size() < nSeries+1) {
+        //Series does not exist yet
+        m_vSeries.resize(nSeries+1);
+        m_vSeries.at(nSeries).fShow = true;
+    }
+    ReleaseModel(nSeries);
+    LineSeries& series = m_vSeries.at(nSeries);
+    std::map<uint32_t, double>().swap(series.data);
+    series.view = LineView();
+    series.fExternal = false;
+    series.source.reset();
+    series.snapshot = ChunkedSeries<double>::Snapshot();
+    series.model = model;
+
+    //A model shown in several series of this chart is only connected once
+    connect(model.get(), &SeriesModel::pointsAppended, this, &LineChart::OnModelPointsAppended, Qt::UniqueConnection);
+    connect(model.get(), &SeriesModel::pointsRemoved, this, &LineChart::OnModelChanged, Qt::UniqueConnection);
+    connect(model.get(), &SeriesModel::dataReset, this, &LineChart::OnModelChanged, Qt::UniqueConnection);
+    MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+    DataChanged();
+}
+
+/**
+ * @brief LineChart::SetSeriesSource : Show a ChunkedSeries that another thread appends to as a line series.
+ * The chart draws a pinned snapshot of the source and only picks up newer versions when it is repainted, so the writer
+ * never has to synchronize with the GUI thread. Call RefreshSources() after appending, queued when called from the writer thread.
+ * @param source
+ * @param nSeries : The index of the series that is being changed or added.
+ */
+void LineChart::SetSeriesSource(const std::shared_ptr<ChunkedSeries<double>>& source, const uint32_t& nSeries)
+{
+    if (!source)
+        return;
+    if (m_vSeries.size() < nSeries+1) {
+        //Series does not exist yet
+        m_vSeries.resize(nSeries+1);
+        m_vSeries.at(nSeries).fShow = true;
+    }
+    ReleaseModel(nSeries);
+    LineSeries& series = m_vSeries.at(nSeries);
+    std::map<uint32_t, double>().swap(series.data);
+    series.view = LineView();
+    series.fExternal = false;
+    series.source = source;
+    series.snapshot = source->Pin();
+    MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+    DataChanged();
+}
+
+/**
+ * @brief LineChart::PinSnapshots : Move every source backed series to the newest published version of its source.
+ * A version that extends the drawn one takes the same incremental path as AppendDataPoints, anything else is rescanned.
+ */
+void LineChart::PinSnapshots()
+{
+    bool fRescan = false;
+    for (size_t i = 0; i < m_vSeries.size(); i++) {
+        LineSeries& series = m_vSeries.at(i);
+        if (!series.source)
+            continue;
+
+        ChunkedSeries<double>::Snapshot snapshot = series.source->Pin();
+        size_t nSizeBefore = series.snapshot.Size();
+        bool fTail = snapshot.SameGeneration(series.snapshot) && snapshot.Size() >= nSizeBefore;
+        if (fTail && snapshot.Size() == nSizeBefore)
+            continue;
+
+        series.snapshot = snapshot;
+        if (!fTail || InUpdate()) {
+            MarkSeriesDirty(i, CACHE_DIRTY_DATA);
+            fRescan = true;
+            continue;
+        }
+        bool fCacheValid = SeriesCacheValid(i) && static_cast<size_t>(m_cachedPlotPoints[i].size()) == nSizeBefore;
+        AppendToSeriesTail(i, series.snapshot.begin() + nSizeBefore, series.snapshot.end(), fCacheValid);
+    }
+    if (fRescan)
+        DataChanged();
+}
+
+/**
+ * @brief LineChart::CreateIngestor : Create a queue that a feed thread pushes points into without touching the chart.
+ * Once per frame the queued points are appended to the series through AppendDataPoints, so sorted points that are newer than
+ * the series' tail only cost their own conversion. A point for an x the series already has replaces its value.
+ * A series has at most one ingestor, creating another replaces it.
+ * @param nSeries : The index of the series that is being fed or added.
+ * @param nCapacity : Points that can be queued between two drains
+ * @param policy : What happens to points that are pushed while the queue is full
+ * @return nullptr if the series is backed by a view, a model or a source, feed those through their owner instead
+ */
+std::shared_ptr<Ingestor<double>> LineChart::CreateIngestor(const uint32_t& nSeries, size_t nCapacity, IngestOverflow policy)
+{
+    if (m_vSeries.size() > nSeries && !OwnsData(m_vSeries.at(nSeries)))
+        return nullptr;
+
+    if (m_vSeries.size() < nSeries+1) {
+        //Series does not exist yet
+        m_vSeries.resize(nSeries+1);
+        m_vSeries.at(nSeries).fShow = true;
+    }
+
+    std::shared_ptr<Ingestor<double>> ingestor = std::make_shared<Ingestor<double>>(nCapacity, policy);
+    auto it = std::find_if(m_vIngestors.begin(), m_vIngestors.end(), [&nSeries](const std::pair<uint32_t, std::shared_ptr<Ingestor<double>>>& pair) {
+        return pair.first == nSeries;
+    });
+    if (it != m_vIngestors.end())
+        it->second = ingestor;
+    else
+        m_vIngestors.emplace_back(nSeries, ingestor);
+    StartIngestTimer();
+    return ingestor;
+}
+
+/**
+ * @brief LineChart::DrainIngestors : Append everything the ingestors queued since the last frame
+ * @return true if any series received points
+ */
+bool LineChart::DrainIngestors()
+{
+    bool fDrained = false;
+    for (const auto& pair : m_vIngestors) {
+        //The series was switched to a view, a model or a source after the ingestor was made, leave its points queued
+        if (m_vSeries.size() < pair.first+1 || !OwnsData(m_vSeries.at(pair.first)))
+            continue;
+        m_vIngestBuffer.clear();
+        if (pair.second->Drain(m_vIngestBuffer) == 0)
+            continue;
+        fDrained = true;
+
+        //Strictly increasing points past the tail take the append fast path
+        std::map<uint32_t, double>& mapData = m_vSeries.at(pair.first).data;
+        bool fIncreasing = std::adjacent_find(m_vIngestBuffer.begin(), m_vIngestBuffer.end(),
+                                              [](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+            return a.first >= b.first;
+        }) == m_vIngestBuffer.end();
+        if (fIncreasing && (mapData.empty() || m_vIngestBuffer.front().first > mapData.rbegin()->first)) {
+            AppendDataPoints(pair.first, m_vIngestBuffer);
+            continue;
+        }
+
+        //Otherwise the latest value pushed for an x wins, including over the one already in the series
+        for (const auto& point : m_vIngestBuffer)
+            mapData[point.first] = point.second;
+        MarkSeriesDirty(pair.first, CACHE_DIRTY_DATA);
+        DataChanged();
+    }
+    return fDrained;
+}
+
+/**
+ * @brief LineChart::RefreshSources : Repaint if a source backed series has a newer version than the one that is drawn
+ */
+void LineChart::RefreshSources()
+{
+    for (const LineSeries& series : m_vSeries) {
+        if (!series.source)
+            continue;
+        ChunkedSeries<double>::Snapshot snapshot = series.source->Pin();
+        if (!snapshot.SameGeneration(series.snapshot) || snapshot.Size() != series.snapshot.Size()) {
+            update();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief LineChart::ReleaseModel : Drop a series' reference to its model, disconnecting from the model if no other series uses it
+ */
+void LineChart::ReleaseModel(const uint32_t& nSeries)
+{
+    std::shared_ptr<SeriesModel> model = std::move(m_vSeries.at(nSeries).model);
+    m_vSeries.at(nSeries).model.reset();
+    DisconnectModel(model.get());
+}
+
+void LineChart::DisconnectModel(const SeriesModel* pModel)
+{
+    if (!pModel)
+        return;
+    for (const LineSeries& series : m_vSeries) {
+        if (series.model.get() == pModel)
+            return;
+    }
+    disconnect(pModel, nullptr, this, nullptr);
+}
+
+/**
+ * @brief LineChart::OnModelPointsAppended : Points were appended to a model, give every series showing it the incremental append handling
+ */
+void LineChart::OnModelPointsAppended(uint32_t nFirstX, uint32_t nLastX)
+{
+    Q_UNUSED(nLastX);
+    for (size_t i = 0; i < m_vSeries.size(); i++) {
+        const LineSeries& series = m_vSeries.at(i);
+        if (!series.model || series.model.get() != sender())
+            continue;
+
+        const std::map<uint32_t, double>& mapPoints = series.model->Points();
+        auto itFirst = mapPoints.lower_bound(nFirstX);
+        size_t nSizeBefore = mapPoints.size() - static_cast<size_t>(std::distance(itFirst, mapPoints.end()));
+        bool fCacheValid = SeriesCacheValid(i) && static_cast<size_t>(m_cachedPlotPoints[i].size()) == nSizeBefore;
+        if (InUpdate()) {
+            MarkSeriesDirty(i, CACHE_DIRTY_DATA);
+            DataChanged();
+            continue;
+        }
+        AppendToSeriesTail(i, itFirst, mapPoints.end(), fCacheValid);
+    }
+    update();
+}
+
+/**
+ * @brief LineChart::OnModelChanged : A model's points were removed or replaced, rebuild every series showing it
+ */
+void LineChart::OnModelChanged()
+{
+    for (size_t i = 0; i < m_vSeries.size(); i++) {
+        if (m_vSeries.at(i).model && m_vSeries.at(i).model.get() == sender())
+            MarkSeriesDirty(i, CACHE_DIRTY_DATA);
+    }
+    DataChanged();
+    update();
+}
+
+/**
+ * @brief LineChart::DataViewAppended : Tell the chart that points were appended to the arrays behind a series' view.
+ * The points already in the view must be unchanged. Points past the previous size are handled like AppendDataPoints,
+ * so in the common case only the new points are converted to screen coordinates.
+ * @param nSeries : The index of the series that is being altered.
+ * @param view : The grown view, which may point at a reallocated buffer
+ */
+void LineChart::DataViewAppended(const uint32_t& nSeries, const LineView& view)
+{
+    if (m_vSeries.size() < nSeries+1 || !m_vSeries.at(nSeries).fExternal) {
+        //Series does not exist, or is not backed by a view
+        return;
+    }
+
+    LineSeries& series = m_vSeries.at(nSeries);
+    size_t nSizeBefore = series.view.Size();
+    series.view = view;
+    if (view.Size() == nSizeBefore)
+        return;
+
+    bool fTail = view.Size() > nSizeBefore && (nSizeBefore == 0 || view.X(nSizeBefore) > view.X(nSizeBefore - 1));
+    bool fCacheValid = fTail && SeriesCacheValid(nSeries) && static_cast<size_t>(m_cachedPlotPoints[nSeries].size()) == nSizeBefore;
+    if (InUpdate() || !fTail) {
+        //Deferred, or the view shrank and needs a full rescan
+        MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+        DataChanged();
+        return;
+    }
+    AppendToSeriesTail(nSeries, view.begin() + nSizeBefore, view.end(), fCacheValid);
+}
+
+/**
+ * @brief LineChart::AppendDataPoints : Add a batch of data points to a specific line series.
+ * Input that is sorted and newer than the series' last point takes a fast path: the extents are only widened by
+ * the new points and, if they did not move, only the new points are converted to screen coordinates.
+ * Unsorted or overlapping input is merged into the series.
+ * @param nSeries : The index of the series that is being altered.
+ * @param pPoints : Array of (x, y) pairs
+ * @param nCount : Number of pairs in pPoints
+ */
+void LineChart::AppendDataPoints(const uint32_t& nSeries, const std::pair<uint32_t, double>* pPoints, size_t nCount)
+{
+    if (m_vSeries.size() < nSeries+1 || nCount == 0 || !OwnsData(m_vSeries.at(nSeries))) {
+        //Series does not exist, or its points are owned by someone else
+        return;
+    }
+
+    std::map<uint32_t, double>& mapData = m_vSeries.at(nSeries).data;
+    size_t nSizeBefore = mapData.size();
+    bool fTail = MergeIntoMap(mapData, pPoints, nCount);
+    bool fCacheValid = fTail && SeriesCacheValid(nSeries) && static_cast<size_t>(m_cachedPlotPoints[nSeries].size()) == nSizeBefore;
+    if (InUpdate() || mapData.size() != nSizeBefore + nCount) {
+        //Deferred, or some points collided with existing x values and need a full rescan
+        MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+        DataChanged();
+        return;
+    }
+    AppendToSeriesTail(nSeries, pPoints, pPoints + nCount, fCacheValid);
+}
+
+/**
+ * @brief LineChart::AppendToSeriesTail : Update the extents and cached screen points for points that were added past the end of a series
+ * @param fCacheValid : The series' cached points matched the data before the new points were added
+ */
+template <typename Iterator>
+void LineChart::AppendToSeriesTail(const uint32_t& nSeries, Iterator itBegin, Iterator itEnd, bool fCacheValid)
+{
+    //Hidden series do not take part in auto-ranging and are not cached until they are shown again
+    if (!m_vSeries.at(nSeries).fShow) {
+        MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+        return;
+    }
+
+    //With a shared x range the y range only covers the visible points, which the new points may or may not be part of
+    std::pair<double, double> pairLinked;
+    if (LinkedXRange(pairLinked)) {
+        MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+        DataChanged();
+        return;
+    }
+
+    //Appending can only widen the extents, so there is no need to rescan the existing data
+    std::pair<double, double> pairXBefore = m_pairXRange;
+    std::pair<double, double> pairYBefore = m_pairYRange;
+    for (Iterator it = itBegin; it != itEnd; ++it) {
+        std::pair<uint32_t, double> pair = *it;
+        IncludeInRange(pair.first, pair.second);
+    }
+    ApplyRange();
+    m_fChangesMade = true;
+
+    //Only a move of the extents changes the screen coordinates of the existing points
+    if (m_pairXRange != pairXBefore || m_pairYRange != pairYBefore) {
+        MarkAllDirty(CACHE_DIRTY_RANGE);
+        return;
+    }
+    if (!fCacheValid) {
+        MarkSeriesDirty(nSeries, CACHE_DIRTY_DATA);
+        return;
+    }
+
+    //Existing screen coordinates are still valid, only convert the new tail
+    QVector<QPointF>& plotPoints = m_cachedPlotPoints[nSeries];
+    plotPoints.reserve(plotPoints.size() + static_cast<int>(std::distance(itBegin, itEnd)));
+    for (Iterator it = itBegin; it != itEnd; ++it)
+        plotPoints.append(ConvertToPlotPoint(*it));
+}
+
+void LineChart::AppendDataPoints(const uint32_t& nSeries, const std::vector<std::pair<uint32_t, double>>& vPoints)
+{
+    if (vPoints.empty())
+        return;
+    AppendDataPoints(nSeries, vPoints.data(), vPoints.size());
 }
 
 void LineChart::RemoveSeries(const uint32_t& nSeries)
@@ -259,13 +807,41 @@ void LineChart::RemoveSeries(const uint32_t& nSeries)
     if (m_vSeries.size() < nSeries + 1) {
         return;
     }
+    std::shared_ptr<SeriesModel> model = std::move(m_vSeries.at(nSeries).model);
     m_vSeries.erase(m_vSeries.begin()+nSeries);
+    DisconnectModel(model.get());
+
+    //Ingestors follow their series to its new index
+    for (auto it = m_vIngestors.begin(); it != m_vIngestors.end();) {
+        if (it->first == nSeries) {
+            it = m_vIngestors.erase(it);
+            continue;
+        }
+        if (it->first > nSeries)
+            it->first--;
+        ++it;
+    }
+    if (m_cachedPlotPoints.size() >= nSeries + 1)
+        m_cachedPlotPoints.erase(m_cachedPlotPoints.begin()+nSeries);
+    if (m_vPlotPointsDirty.size() >= nSeries + 1)
+        m_vPlotPointsDirty.erase(m_vPlotPointsDirty.begin()+nSeries);
+    DataChanged();
 }
 
 void LineChart::ClearAll()
 {
+    for (const LineSeries& series : m_vSeries) {
+        if (series.model)
+            disconnect(series.model.get(), nullptr, this, nullptr);
+    }
     m_vSeries.clear();
     m_vVolume.clear();
+    m_vIngestors.clear();
+    m_cachedPlotPoints.clear();
+    m_cachedVolumePoints.clear();
+    m_vPlotPointsDirty.clear();
+    m_vVolumePointsDirty.clear();
+    DataChanged();
 }
 
 // Keeps data in chart series, but does not paint the line
@@ -275,7 +851,12 @@ void LineChart::HideSeries(const uint32_t& nSeries, bool fHide)
     if (m_vSeries.size() < nSeries + 1) {
         return;
     }
+    if (m_vSeries.at(nSeries).fShow == !fHide)
+        return;
     m_vSeries.at(nSeries).fShow = !fHide;
+
+    //Hidden series are left out of the extents, so the range may move
+    DataChanged();
 }
 
 bool LineChart::SeriesHidden(const uint32_t &nSeries)
@@ -333,8 +914,53 @@ void LineChart::AddVolumePoint(const uint32_t& nSeries, const uint32_t& x, const
         //Series does not exist
         return;
     }
-    m_vVolume.at(nSeries).data.emplace(x, y);
-    ProcessChangedData();
+    std::map<uint32_t, double>& mapData = m_vVolume.at(nSeries).data;
+    size_t nSizeBefore = mapData.size();
+    bool fTail = mapData.empty() || x > mapData.rbegin()->first;
+    bool fCacheValid = fTail && VolumeCacheValid(nSeries) && static_cast<size_t>(m_cachedVolumePoints[nSeries].size()) == nSizeBefore;
+    mapData.emplace(x, y);
+    if (InUpdate() || !fCacheValid) {
+        MarkVolumeDirty(nSeries, CACHE_DIRTY_DATA);
+        DataChanged();
+        return;
+    }
+
+    //Volume does not affect the extents, so a new tail point only needs its own screen point
+    m_cachedVolumePoints[nSeries].append(ConvertToVolumePoint(std::make_pair(x, y)));
+    m_fChangesMade = true;
+}
+
+/**
+ * @brief LineChart::AppendVolumePoints : Add a batch of volume points to a specific series, creating the volume series if needed.
+ * Volume does not affect the extents, so sorted input newer than the last volume point only converts the new points.
+ * @param nSeries : index of the series being altered
+ * @param pPoints : Array of (x, volume) pairs
+ * @param nCount : Number of pairs in pPoints
+ */
+void LineChart::AppendVolumePoints(const uint32_t& nSeries, const std::pair<uint32_t, double>* pPoints, size_t nCount)
+{
+    if (nCount == 0)
+        return;
+    if (m_vVolume.size() < nSeries+1) {
+        //Series does not exist yet
+        m_vVolume.resize(nSeries+1);
+    }
+
+    std::map<uint32_t, double>& mapData = m_vVolume.at(nSeries).data;
+    size_t nSizeBefore = mapData.size();
+    bool fTail = MergeIntoMap(mapData, pPoints, nCount);
+    bool fCacheValid = fTail && VolumeCacheValid(nSeries) && static_cast<size_t>(m_cachedVolumePoints[nSeries].size()) == nSizeBefore;
+    if (InUpdate() || !fCacheValid || mapData.size() != nSizeBefore + nCount) {
+        MarkVolumeDirty(nSeries, CACHE_DIRTY_DATA);
+        DataChanged();
+        return;
+    }
+
+    QVector<QPointF>& volumePoints = m_cachedVolumePoints[nSeries];
+    volumePoints.reserve(volumePoints.size() + static_cast<int>(nCount));
+    for (size_t i = 0; i < nCount; i++)
+        volumePoints.append(ConvertToVolumePoint(pPoints[i]));
+    m_fChangesMade = true;
 }
 
 /**
@@ -349,7 +975,8 @@ void LineChart::RemoveVolumePoint(const uint32_t& nSeries, const uint32_t &x)
         return;
     }
     m_vVolume.at(nSeries).data.erase(x);
-    ProcessChangedData();
+    MarkVolumeDirty(nSeries, CACHE_DIRTY_DATA);
+    DataChanged();
 }
 
 /**
@@ -358,41 +985,174 @@ void LineChart::RemoveVolumePoint(const uint32_t& nSeries, const uint32_t &x)
  * @param nSeries : The index of the series that is being changed or added
  */
 void LineChart::SetVolumePoints(const std::map<uint32_t, double>& mapPoints, const uint32_t& nSeries)
+{
+    SetVolumePoints(std::map<uint32_t, double>(mapPoints), nSeries);
+}
+
+/**
+ * @brief LineChart::SetVolumePoints : Set the volume datapoints of a specific line series, taking ownership of the map without copying it.
+ * @param mapPoints
+ * @param nSeries : The index of the series that is being changed or added
+ */
+void LineChart::SetVolumePoints(std::map<uint32_t, double>&& mapPoints, const uint32_t& nSeries)
 {
     if (m_vVolume.size() < nSeries+1) {
         //Series does not exist yet
         m_vVolume.resize(nSeries+1);
     }
-    m_vVolume.at(nSeries).data = mapPoints;
-    ProcessChangedData();
+    m_vVolume.at(nSeries).data = std::move(mapPoints);
+    MarkVolumeDirty(nSeries, CACHE_DIRTY_DATA);
+    DataChanged();
 }
 
 void LineChart::ProcessChangedData()
 {
-    m_pairXRange = {0, 0};
-    m_pairYRange = {0, 0};
-    bool fFirstRun = true;
+    std::pair<double, double> pairXBefore = m_pairXRange;
+    std::pair<double, double> pairYBefore = m_pairYRange;
+
+    m_pairXDataRange = {0, 0};
+    m_pairYDataRange = {0, 0};
+    m_fHaveDataRange = false;
+
+    //With a shared x range only the visible points are scanned, the x range is taken as it is. The neighbours that the
+    //clipped line runs to are left out, so they do not stretch the y range.
+    std::pair<double, double> pairLinked;
+    uint32_t nStart = 0;
+    uint32_t nEnd = 0;
+    bool fLinked = LinkedXRange(pairLinked);
+    if (fLinked)
+        m_pChartGroup->XRangeTimes(nStart, nEnd);
+
     for (const LineSeries& series : m_vSeries) {
-        for (const auto& pair : series.data) {
-            //Set min and max for x and y
-            if (fFirstRun || pair.first < m_pairXRange.first)
-                m_pairXRange.first = pair.first;
-            if (fFirstRun || pair.first > m_pairXRange.second)
-                m_pairXRange.second = pair.first;
-            if (fFirstRun || pair.second < m_pairYRange.first)
-                m_pairYRange.first = pair.second;
-            if (fFirstRun || pair.second > m_pairYRange.second)
-                m_pairYRange.second = pair.second;
-            fFirstRun = false;
+        if (!series.fShow)
+            continue;
+        if (fLinked) {
+            //Members showing the same model share its visible index range
+            size_t nFirst, nLast;
+            double dMin, dMax;
+            const SeriesIndex* pIndex = series.model ? &series.model->PointIndex() : nullptr;
+            if (pIndex && m_pChartGroup->VisibleIndexes(*pIndex, nFirst, nLast)) {
+                if (m_pChartGroup->VisibleMinMax(*pIndex, dMin, dMax)) {
+                    IncludeInRange(pIndex->Time(nFirst), dMin);
+                    IncludeInRange(pIndex->Time(nLast - 1), dMax);
+                }
+                continue;
+            }
+            //A view takes the y range from its range index if it has one, a mapped file then only reads the rows at the ends
+            if (series.fExternal && !series.source && !series.model) {
+                nFirst = series.view.LowerBound(nStart);
+                nLast = series.view.UpperBound(nEnd);
+                if (series.view.MinMaxAt(nFirst, nLast, dMin, dMax)) {
+                    IncludeInRange(series.view.X(nFirst), dMin);
+                    IncludeInRange(series.view.X(nLast - 1), dMax);
+                }
+                continue;
+            }
+            ForEachPointIn(series, nStart, nEnd, false, [this](const std::pair<uint32_t, double>& pair) {
+                IncludeInRange(pair.first, pair.second);
+            });
+            continue;
         }
+
+        //A model keeps its own extents, so its points do not need to be scanned
+        std::pair<double, double> pairX;
+        std::pair<double, double> pairY;
+        if (series.model) {
+            if (series.model->Extents(pairX, pairY)) {
+                IncludeInRange(static_cast<uint32_t>(pairX.first), pairY.first);
+                IncludeInRange(static_cast<uint32_t>(pairX.second), pairY.second);
+            }
+            continue;
+        }
+        if (series.fExternal && !series.source) {
+            //Views take the y range from their range index if they have one, so a mapped file is not paged in for its extents
+            double dMin, dMax;
+            if (series.view.MinMaxAt(0, series.view.Size(), dMin, dMax)) {
+                IncludeInRange(series.view.X(0), dMin);
+                IncludeInRange(series.view.X(series.view.Size() - 1), dMax);
+            }
+            continue;
+        }
+        ForEachPoint(series, [this](const std::pair<uint32_t, double>& pair) {
+            IncludeInRange(pair.first, pair.second);
+        });
+    }
+    ApplyRange();
+    m_fChangesMade = true;
+
+    //Only series whose data changed need new screen points, unless the extents moved
+    if (m_pairXRange != pairXBefore || m_pairYRange != pairYBefore)
+        MarkAllDirty(CACHE_DIRTY_RANGE);
+}
+
+/**
+ * @brief LineChart::IncludeInRange: Widen the raw data extents so that they include a data point
+ */
+void LineChart::IncludeInRange(const uint32_t& x, const double& y)
+{
+    //Set min and max for x and y
+    if (!m_fHaveDataRange || x < m_pairXDataRange.first)
+        m_pairXDataRange.first = x;
+    if (!m_fHaveDataRange || x > m_pairXDataRange.second)
+        m_pairXDataRange.second = x;
+    if (!m_fHaveDataRange || y < m_pairYDataRange.first)
+        m_pairYDataRange.first = y;
+    if (!m_fHaveDataRange || y > m_pairYDataRange.second)
+        m_pairYDataRange.second = y;
+    m_fHaveDataRange = true;
+}
+
+/**
+ * @brief HeadroomRange: Autoscale with hysteresis. The current range is kept as long as the data still fits inside
+ * it and it has not become much looser than needed, otherwise a new range is made with headroom added to each side.
+ * @param pairData: min, max of the data
+ * @param pairCurrent: the range currently displayed
+ * @param dLow: fraction of the data span to add below the minimum
+ * @param dHigh: fraction of the data span to add above the maximum
+ * @return the range to display
+ */
+static std::pair<double, double> HeadroomRange(const std::pair<double, double>& pairData, const std::pair<double, double>& pairCurrent,
+                                               double dLow, double dHigh)
+{
+    double dSpan = pairData.second - pairData.first;
+    bool fFits = pairCurrent.first <= pairData.first && pairData.second <= pairCurrent.second;
+    bool fTooLoose = (pairCurrent.second - pairCurrent.first) > dSpan * (1 + 2*(dLow + dHigh));
+    if (fFits && !fTooLoose)
+        return pairCurrent;
+    return std::make_pair(pairData.first - dSpan*dLow, pairData.second + dSpan*dHigh);
+}
+
+/**
+ * @brief LineChart::ApplyRange: Derive the displayed x and y ranges from the raw data extents
+ */
+void LineChart::ApplyRange()
+{
+    //A shared x range is shown as it is, without headroom
+    std::pair<double, double> pairLinked;
+    bool fLinked = LinkedXRange(pairLinked);
+    if (!m_fHaveDataRange) {
+        m_pairXRange = fLinked ? pairLinked : m_pairXDataRange;
+        m_pairYScaledRange = m_pairYDataRange;
+        m_pairYRange = m_pairYDataRange;
+        return;
     }
+
+    //Time only moves forward, so x headroom is only added past the newest point
+    if (fLinked)
+        m_pairXRange = pairLinked;
+    else
+        m_pairXRange = m_dXHeadroom > 0 ? HeadroomRange(m_pairXDataRange, m_pairXRange, 0, m_dXHeadroom) : m_pairXDataRange;
+    m_pairYScaledRange = m_dYHeadroom > 0 ? HeadroomRange(m_pairYDataRange, m_pairYScaledRange, m_dYHeadroom, m_dYHeadroom) : m_pairYDataRange;
+    //Don't let the headroom push a non-negative series below zero
+    if (m_pairYDataRange.first >= 0 && m_pairYScaledRange.first < 0)
+        m_pairYScaledRange.first = 0;
+    m_pairYRange = m_pairYScaledRange;
+
     // Add y-axis buffer for the volume bars
     if(m_fDrawVolume) {
         double buffer = m_yPadding * (m_pairYRange.second - m_pairYRange.first) / 10;
         m_pairYRange.first -= buffer;
     }
-    m_fChangesMade = true;
-    m_fPlotPointsDirty = true; // Mark cached points as dirty when data changes
 }
 
 /**
@@ -407,6 +1167,45 @@ void LineChart::GetLineEquation(const QLineF& line, double& nSlope, double& nYIn
     nYIntercept = line.y1() - (nSlope * line.x1());
 }
 
+/**
+ * @brief LineChart::ValueAt Value of a series at an x, interpolated along the line between the points on either side of it.
+ * Found by binary search whatever the series is stored in.
+ * @return false if the series does not exist or x is outside of it
+ */
+bool LineChart::ValueAt(const uint32_t& nSeries, double x, double& y) const
+{
+    if (nSeries >= m_vSeries.size())
+        return false;
+    PointsAround around = FindPointsAround(m_vSeries[nSeries], x);
+    if (!around.fBefore || !around.fAfter)
+        return false;
+    if (around.pairAfter.first == around.pairBefore.first) {
+        y = around.pairAfter.second;
+        return true;
+    }
+    double dFraction = (x - around.pairBefore.first) / (around.pairAfter.first - around.pairBefore.first);
+    y = around.pairBefore.second + dFraction * (around.pairAfter.second - around.pairBefore.second);
+    return true;
+}
+
+/**
+ * @brief LineChart::NearestPoint The point of a series with the x closest to an x, found by binary search
+ * @return false if the series does not exist or is empty
+ */
+bool LineChart::NearestPoint(const uint32_t& nSeries, double x, std::pair<uint32_t, double>& point) const
+{
+    if (nSeries >= m_vSeries.size())
+        return false;
+    PointsAround around = FindPointsAround(m_vSeries[nSeries], x);
+    if (around.fBefore && (!around.fAfter || x - around.pairBefore.first <= around.pairAfter.first - x))
+        point = around.pairBefore;
+    else if (around.fAfter)
+        point = around.pairAfter;
+    else
+        return false;
+    return true;
+}
+
 QColor LineChart::GetSeriesColor(const uint32_t& nSeries) const
 {
     QColor color = Qt::black;
@@ -426,40 +1225,177 @@ QColor LineChart::GetSeriesColor(const uint32_t& nSeries) const
 }
 
 /**
- * @brief LineChart::UpdateCachedPoints Convert data points to screen coordinates and cache them
+ * @brief LineChart::MarkSeriesDirty Flag the cached screen points of a line series for rebuilding
+ * @param nSeries: index of the series
+ * @param flags: CacheDirtyFlag bits giving the reason
+ */
+void LineChart::MarkSeriesDirty(const uint32_t& nSeries, uint8_t flags)
+{
+    if (m_vPlotPointsDirty.size() < nSeries + 1)
+        m_vPlotPointsDirty.resize(nSeries + 1, CACHE_DIRTY_DATA);
+    m_vPlotPointsDirty[nSeries] |= flags;
+    m_fChangesMade = true;
+}
+
+/**
+ * @brief LineChart::MarkVolumeDirty Flag the cached screen points of a volume series for rebuilding
+ * @param nSeries: index of the series
+ * @param flags: CacheDirtyFlag bits giving the reason
  */
+void LineChart::MarkVolumeDirty(const uint32_t& nSeries, uint8_t flags)
+{
+    if (m_vVolumePointsDirty.size() < nSeries + 1)
+        m_vVolumePointsDirty.resize(nSeries + 1, CACHE_DIRTY_DATA);
+    m_vVolumePointsDirty[nSeries] |= flags;
+    m_fChangesMade = true;
+}
+
+/**
+ * @brief LineChart::MarkAllDirty Flag the cached screen points of every series, used when the
+ * geometry or the extents of the chart change
+ * @param flags: CacheDirtyFlag bits giving the reason
+ */
+void LineChart::MarkAllDirty(uint8_t flags)
+{
+    for (uint8_t& nDirty : m_vPlotPointsDirty)
+        nDirty |= flags;
+    for (uint8_t& nDirty : m_vVolumePointsDirty)
+        nDirty |= flags;
+    m_fChangesMade = true;
+}
+
+/**
+ * @brief LineChart::SeriesCacheValid Whether the cached screen points of a series can be used or extended as they are
+ * @param nSeries: index of the series
+ */
+bool LineChart::SeriesCacheValid(const uint32_t& nSeries) const
+{
+    if (m_cachedPlotPoints.size() < nSeries + 1 || m_vPlotPointsDirty.size() < nSeries + 1)
+        return false;
+    return m_vPlotPointsDirty[nSeries] == CACHE_CLEAN && ChartArea() == m_rectCachedChart;
+}
+
+/**
+ * @brief LineChart::VolumeCacheValid Whether the cached screen points of a volume series can be used or extended as they are
+ * @param nSeries: index of the series
+ */
+bool LineChart::VolumeCacheValid(const uint32_t& nSeries) const
+{
+    if (m_cachedVolumePoints.size() < nSeries + 1 || m_vVolumePointsDirty.size() < nSeries + 1)
+        return false;
+    return m_vVolumePointsDirty[nSeries] == CACHE_CLEAN && ChartArea() == m_rectCachedChart;
+}
+
+/**
+ * @brief LineChart::UpdateCachedPoints Convert data points to screen coordinates and cache them. Only the
+ * series that have been flagged dirty are converted again, and hidden series are skipped until they are shown.
+ */
+/**
+ * @brief LineChart::ConvertViewPoints Convert the points of a view in [nFirst, nLast) to screen coordinates. When a view with
+ * a range index has many more points than the chart has pixel columns, each column only gets its first and last point and
+ * the y range in between. The buckets are whole blocks of the index, so the rows inside them are never read.
+ */
+void LineChart::ConvertViewPoints(const LineView& view, size_t nFirst, size_t nLast, QVector<QPointF>& plotPoints) const
+{
+    const ViewRangeIndex* pIndex = view.RangeIndex();
+    size_t nColumns = static_cast<size_t>(std::max(1, ChartArea().width()));
+    size_t nRowsPerColumn = nLast > nFirst ? (nLast - nFirst) / nColumns : 0;
+    size_t nBlockRows = pIndex ? pIndex->BlockRows() : 0;
+    if (nBlockRows == 0 || nRowsPerColumn < std::max<size_t>(nBlockRows, 8)) {
+        plotPoints.reserve(static_cast<int>(nLast - nFirst));
+        for (size_t i = nFirst; i < nLast; i++)
+            plotPoints.append(ConvertToPlotPoint(view.At(i)));
+        return;
+    }
+
+    //Bucket ends are rounded down to a block boundary, only the first bucket can start inside a block
+    size_t nBucketRows = (nRowsPerColumn + nBlockRows - 1) / nBlockRows * nBlockRows;
+    plotPoints.reserve(static_cast<int>(4 * (nColumns + 2)));
+    size_t nRow = nFirst;
+    while (nRow < nLast) {
+        size_t nEnd = std::min(nLast, (nRow + nBucketRows) / nBlockRows * nBlockRows);
+        double dMin, dMax;
+        pIndex->RowRange(nRow, nEnd, dMin, dMax);
+        uint32_t xFirst = view.X(nRow);
+        uint32_t xMiddle = xFirst + (view.X(nEnd - 1) - xFirst) / 2;
+        plotPoints.append(ConvertToPlotPoint(view.At(nRow)));
+        plotPoints.append(ConvertToPlotPoint(std::make_pair(xMiddle, dMin)));
+        plotPoints.append(ConvertToPlotPoint(std::make_pair(xMiddle, dMax)));
+        plotPoints.append(ConvertToPlotPoint(view.At(nEnd - 1)));
+        nRow = nEnd;
+    }
+}
+
 void LineChart::UpdateCachedPoints()
 {
-    if (!m_fPlotPointsDirty) {
-        return; // Points are already up to date
+    //A different chart area moves every screen coordinate
+    QRect rectChart = ChartArea();
+    if (rectChart != m_rectCachedChart) {
+        m_rectCachedChart = rectChart;
+        MarkAllDirty(CACHE_DIRTY_GEOMETRY);
     }
 
-    // Clear existing cached points
-    m_cachedPlotPoints.clear();
-    m_cachedVolumePoints.clear();
-    
-    // Resize containers to match number of series
+    // Resize containers to match number of series, new entries start out dirty
     m_cachedPlotPoints.resize(m_vSeries.size());
+    m_vPlotPointsDirty.resize(m_vSeries.size(), CACHE_DIRTY_DATA);
     m_cachedVolumePoints.resize(m_vVolume.size());
+    m_vVolumePointsDirty.resize(m_vVolume.size(), CACHE_DIRTY_DATA);
     
-    // Convert all series data points to screen coordinates
+    //With a shared x range only the visible points and their neighbours are converted
+    std::pair<double, double> pairLinked;
+    uint32_t nStart = 0;
+    uint32_t nEnd = 0;
+    bool fLinked = LinkedXRange(pairLinked);
+    if (fLinked)
+        m_pChartGroup->XRangeTimes(nStart, nEnd);
+
+    // Convert the changed series data points to screen coordinates
     for (size_t i = 0; i < m_vSeries.size(); i++) {
         const LineSeries& series = m_vSeries.at(i);
+        if (m_vPlotPointsDirty[i] == CACHE_CLEAN || !series.fShow)
+            continue;
+
         QVector<QPointF>& plotPoints = m_cachedPlotPoints[i];
+        plotPoints.clear();
+        auto convertPoint = [this, &plotPoints](const std::pair<uint32_t, double>& pair) {
+            plotPoints.append(ConvertToPlotPoint(pair));
+        };
+        if (series.fExternal && !series.source && !series.model) {
+            //Views are converted by row range, so a view on a mapped file only reads the rows it has to
+            size_t nFirst = 0;
+            size_t nLast = series.view.Size();
+            if (fLinked) {
+                nFirst = series.view.LowerBound(nStart);
+                nLast = series.view.UpperBound(nEnd);
+                nFirst = nFirst > 0 ? nFirst - 1 : 0;
+                nLast = std::min(nLast + 1, series.view.Size());
+            }
+            ConvertViewPoints(series.view, nFirst, nLast, plotPoints);
+            m_vPlotPointsDirty[i] = CACHE_CLEAN;
+            continue;
+        }
+        if (fLinked) {
+            ForEachPointIn(series, nStart, nEnd, true, convertPoint);
+            m_vPlotPointsDirty[i] = CACHE_CLEAN;
+            continue;
+        }
         
         // Reserve space to avoid reallocations
-        plotPoints.reserve(series.data.size());
+        plotPoints.reserve(static_cast<int>(SeriesSize(series)));
         
         // Convert each data point to screen coordinates
-        for (const auto& pair : series.data) {
-            plotPoints.append(ConvertToPlotPoint(pair));
-        }
+        ForEachPoint(series, convertPoint);
+        m_vPlotPointsDirty[i] = CACHE_CLEAN;
     }
     
     // Convert volume data points
     for (size_t i = 0; i < m_vVolume.size(); i++) {
+        if (m_vVolumePointsDirty[i] == CACHE_CLEAN)
+            continue;
+
         const LineSeries& series = m_vVolume.at(i);
         QVector<QPointF>& volumePoints = m_cachedVolumePoints[i];
+        volumePoints.clear();
         
         // Reserve space to avoid reallocations
         volumePoints.reserve(series.data.size());
@@ -468,14 +1404,14 @@ void LineChart::UpdateCachedPoints()
         for (const auto& pair : series.data) {
             volumePoints.append(ConvertToVolumePoint(pair));
         }
+        m_vVolumePointsDirty[i] = CACHE_CLEAN;
     }
-    
-    m_fPlotPointsDirty = false; // Mark points as up to date
 }
 
 void LineChart::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
+    //Draw the newest version of any series written by another thread, it stays pinned until the next paint
+    PinSnapshots();
 
     //Fill in the background first
     QPainter painter(this);
@@ -517,10 +1453,8 @@ void LineChart::paintEvent(QPaintEvent *event)
     QRect rectFull = rect();
     QRect rectChart = ChartArea();
 
-    // Update the cached points if necessary (data changed or resize occurred)
-    if (m_fPlotPointsDirty || m_fChangesMade) {
-        UpdateCachedPoints();
-    }
+    // Update the cached points of any series whose data, geometry or range changed
+    UpdateCachedPoints();
 
     // Determine if mouse location is inside of the chart, but only if mouse display is enabled
     QPoint lposMouse;
@@ -544,6 +1478,12 @@ void LineChart::paintEvent(QPaintEvent *event)
         m_lastMouseInChartArea = fMouseInChartArea;
     }
 
+    //The mouse is over another chart of the group, show the dots at the same x
+    QPoint pointLinked;
+    bool fLinkedHover = !fMouseInChartArea && LinkedHoverPoint(pointLinked);
+    if (fLinkedHover)
+        lposMouse = pointLinked;
+
     //Clear any existing mouse dots and save current state before clearing
     m_lastMouseDots = m_mousedisplay.GetDots();
     m_mousedisplay.ClearDots();
@@ -563,10 +1503,19 @@ void LineChart::paintEvent(QPaintEvent *event)
         painter.restore();
     }
 
+    //A partial repaint, usually the crosshair of a linked hover, only strokes the part of each line inside the dirty area
+    bool fFullPaint = event->region().contains(rectChart);
+    QRect rectDirty = event->region().boundingRect();
+
+    //With a shared x range the neighbours of the visible points lie outside of the chart area
+    painter.save();
+    if (XAxisLinked())
+        painter.setClipRect(rectChart);
+
     //Draw each series
     for (unsigned int i = 0; i < m_vSeries.size(); i++) {
         const LineSeries& series = m_vSeries.at(i);
-        if (!series.fShow || series.data.empty())
+        if (!series.fShow || SeriesSize(series) == 0)
             continue;
 
         // Use cached plot points instead of converting during paint
@@ -576,46 +1525,49 @@ void LineChart::paintEvent(QPaintEvent *event)
         // Ensure we have cached data for this series
         if (i < m_cachedPlotPoints.size()) {
             const QVector<QPointF>& cachedPoints = m_cachedPlotPoints[i];
+
+            // Points to draw, reaching one point past each side of the dirty area so the lines cross its edges
+            int nFirst = 0;
+            int nLast = cachedPoints.size();
+            if (!fFullPaint) {
+                auto cmpX = [](const QPointF& point, int x) { return point.x() < x; };
+                nFirst = static_cast<int>(std::lower_bound(cachedPoints.begin(), cachedPoints.end(), rectDirty.left(), cmpX) - cachedPoints.begin());
+                nLast = static_cast<int>(std::lower_bound(cachedPoints.begin() + nFirst, cachedPoints.end(), rectDirty.right() + 1, cmpX) - cachedPoints.begin());
+                nFirst = std::max(0, nFirst - 1);
+                nLast = std::min(cachedPoints.size(), nLast + 1);
+            }
             
             // Create polygon starting with bottom-left corner
-            qvecPolygon.append(rectChart.bottomLeft());
+            if (nFirst == 0)
+                qvecPolygon.append(rectChart.bottomLeft());
+            else
+                qvecPolygon.append(QPointF(cachedPoints[nFirst].x(), rectChart.bottom()));
             
-            // Add all cached points to the polygon
-            qvecPolygon.append(cachedPoints);
+            // Add the cached points to the polygon
+            for (int j = nFirst; j < nLast; j++)
+                qvecPolygon.append(cachedPoints[j]);
             
             // Add lines between points
-            if (cachedPoints.size() > 1) {
-                for (int j = 1; j < cachedPoints.size(); j++) {
-                    qvecLines.append(QLineF(cachedPoints[j-1], cachedPoints[j]));
-                }
-            }
+            for (int j = nFirst + 1; j < nLast; j++)
+                qvecLines.append(QLineF(cachedPoints[j-1], cachedPoints[j]));
             
             // Handle mouse interactions with lines
-            if (fMouseInChartArea) {
-                bool fMouseSet = false;
-                for (const QLineF& line : qvecLines) {
-                    if (!fMouseSet && lposMouse.x() >= line.x1() && lposMouse.x() <= line.x2()) {
-                        double nLineSlope = 0;
-                        double nLineYIntercept = 0;
-                        GetLineEquation(line, nLineSlope, nLineYIntercept);
-                        double y = nLineSlope * lposMouse.x() + nLineYIntercept;
-                        fMouseSet = true;
-                        QColor color = GetSeriesColor(i);
-                        m_mousedisplay.AddDot(QPointF(lposMouse.x(), y), color);
-                    }
-                }
-            }
+            QPointF pointDot;
+            if ((fMouseInChartArea || fLinkedHover) && HoverDotAt(i, lposMouse.x(), pointDot))
+                m_mousedisplay.AddDot(pointDot, GetSeriesColor(i));
             
             // Cleanly close the polygon
-            qvecPolygon.append(QPointF(rectChart.right(), rectChart.bottom()));
+            if (nLast == cachedPoints.size())
+                qvecPolygon.append(QPointF(rectChart.right(), rectChart.bottom()));
+            else
+                qvecPolygon.append(QPointF(cachedPoints[nLast-1].x(), rectChart.bottom()));
             
             // Get the last data point for labels
             QPointF pointLast;
             double dataLast = 0;
             
-            if (!series.data.empty()) {
-                auto lastDataIter = series.data.rbegin();
-                dataLast = lastDataIter->second;
+            if (SeriesSize(series) > 0) {
+                dataLast = LastValue(series);
                 
                 if (!cachedPoints.empty()) {
                     pointLast = cachedPoints.last();
@@ -707,6 +1659,7 @@ void LineChart::paintEvent(QPaintEvent *event)
             }
         }
     }
+    painter.restore();
     painter.save();
     painter.restore();
 
@@ -768,13 +1721,21 @@ void LineChart::paintEvent(QPaintEvent *event)
             DrawXLabels(painter, vXPoints, /*drawIndicatorLine*/true);
 
             // Give detail about where mouse is located
-            if (m_mousedisplay.IsEnabled() && fMouseInChartArea) {
+            if (m_mousedisplay.IsEnabled() && (fMouseInChartArea || fLinkedHover)) {
                 //Draw the x label
                 DrawXLabels(painter, {lposMouse.x()}, /*drawIndicatorLine*/false);
             }
         }
     }
 
+    //Draw annotations over the series, only the ones inside the visible range are visited
+    if (!m_annotations.Empty()) {
+        AnnotationBox boxVisible(static_cast<uint32_t>(std::max(0.0, MinX())), static_cast<uint32_t>(std::max(0.0, std::ceil(MaxX()))), MinY(), MaxY());
+        m_annotations.Paint(painter, rectChart, boxVisible, [this](uint32_t nTime, double dValue) {
+            return ConvertToPlotPoint(std::make_pair(nTime, dValue));
+        });
+    }
+
     //Draw axis
     if (m_fDrawXAxis) {
         QLineF axisX(rectChart.bottomLeft(), rectChart.bottomRight());
@@ -817,17 +1778,20 @@ void LineChart::paintEvent(QPaintEvent *event)
         painter.restore();
     }
 
-    //Draw mouse display
-    if (m_mousedisplay.IsEnabled() && fMouseInChartArea) {
+    //Draw mouse display, a linked hover only has an x so it only gets the vertical line
+    if (m_mousedisplay.IsEnabled() && (fMouseInChartArea || fLinkedHover)) {
         //Cross hair lines
         painter.setPen(m_mousedisplay.Pen());
-        QPointF posLeft(rectChart.left(), lposMouse.y());
-        QPointF posRight(rectChart.right(), lposMouse.y());
-        QLineF lineMouseX(posLeft, posRight);
-        painter.drawLine(lineMouseX);
+        if (fMouseInChartArea) {
+            QPointF posLeft(rectChart.left(), lposMouse.y());
+            QPointF posRight(rectChart.right(), lposMouse.y());
+            QLineF lineMouseX(posLeft, posRight);
+            painter.drawLine(lineMouseX);
+        }
         QPointF posTop(lposMouse.x(), rectChart.top());
         QPointF posBottom(lposMouse.x(), rectChart.bottom());
         painter.drawLine(QLineF(posTop, posBottom));
+        painter.setFont(font());
 
         std::vector<MouseDot> vDots = m_mousedisplay.GetDots();
         for (const MouseDot& mousedot : vDots) {
@@ -850,21 +1814,10 @@ void LineChart::paintEvent(QPaintEvent *event)
             //        painter.drawPath(pathDot);
 
             //Draw a small tooltip looking item showing the point's data (x,y)
-            auto pairData = ConvertFromPlotPoint(pointCircleCenter);
-            const uint32_t& nX = pairData.first;
-            const double& nY = pairData.second;
-            QString strLabel = "(";
-            if (m_settingsXLabels.labeltype == AxisLabelType::AX_TIMESTAMP) {
-                strLabel += TimeStampToString(nX);
-            } else {
-                strLabel += PrecisionToString(nX, m_settingsXLabels.Precision());
-            }
-            strLabel += ", ";
-            strLabel += PrecisionToString(nY, m_settingsYLabels.Precision());
-            strLabel += ")";
+            QString strLabel = TooltipLabel(pointCircleCenter);
 
             //Create the background of the tooltip
-            QRect rectDraw = MouseOverTooltipRect(painter, rectFull, pointCircleCenter, strLabel);
+            QRect rectDraw = MouseOverTooltipRect(font(), rectFull, pointCircleCenter, strLabel);
 
             QPainterPath pathBackground;
             pathBackground.addRoundedRect(rectDraw, 5, 5);
@@ -881,15 +1834,15 @@ void LineChart::paintEvent(QPaintEvent *event)
 
 /**
  * @brief LineChart::MouseOverTooltipRect Get the boundaries of the tooltip that is drawn for the mouseover data.
- * @param painter: The chart widget's painter.
+ * @param fontLabel: The font the tooltip is drawn with.
  * @param rectFull: The QRect of the entire drawing area of the chart widget.
  * @param pointCircleCenter: the center of the dot that is being drawn for the mouseover.
  * @param strLabel: the label text that is being placed in the tooltip.
  * @return QRect with the coordinates that the tooltip should be drawn in.
  */
-QRect LineChart::MouseOverTooltipRect(const QPainter& painter, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const
+QRect LineChart::MouseOverTooltipRect(const QFont& fontLabel, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const
 {
-    QFontMetrics fm(painter.font());
+    QFontMetrics fm(fontLabel);
     int nWidthText = fm.horizontalAdvance(strLabel) + 4;
 
     //Place the tooltip right below the dot being displayed.
@@ -909,6 +1862,84 @@ QRect LineChart::MouseOverTooltipRect(const QPainter& painter, const QRect& rect
     return rectDraw;
 }
 
+/**
+ * @brief LineChart::HoverDotAt Where the line of a series crosses a screen x, using the cached points of the last paint.
+ * Screen x grows with data x, so the segment under x is found by binary search.
+ * @return false if the series has no segment under x
+ */
+bool LineChart::HoverDotAt(const uint32_t& nSeries, int x, QPointF& point)
+{
+    if (nSeries >= m_cachedPlotPoints.size())
+        return false;
+    const QVector<QPointF>& cachedPoints = m_cachedPlotPoints[nSeries];
+    if (cachedPoints.size() < 2)
+        return false;
+
+    auto it = std::lower_bound(cachedPoints.begin(), cachedPoints.end(), x,
+                               [](const QPointF& pointCached, int x) { return pointCached.x() < x; });
+    int j = std::max(1, static_cast<int>(it - cachedPoints.begin()));
+    if (j >= cachedPoints.size() || x < cachedPoints[j-1].x())
+        return false;
+
+    double nLineSlope = 0;
+    double nLineYIntercept = 0;
+    GetLineEquation(QLineF(cachedPoints[j-1], cachedPoints[j]), nLineSlope, nLineYIntercept);
+    point = QPointF(x, nLineSlope * x + nLineYIntercept);
+    return true;
+}
+
+/**
+ * @brief LineChart::TooltipLabel The (x, y) text of the mouse display tooltip for a dot
+ */
+QString LineChart::TooltipLabel(const QPointF& pointDot)
+{
+    auto pairData = ConvertFromPlotPoint(pointDot);
+    const uint32_t& nX = pairData.first;
+    const double& nY = pairData.second;
+    QString strLabel = "(";
+    if (m_settingsXLabels.labeltype == AxisLabelType::AX_TIMESTAMP) {
+        strLabel += TimeStampToString(nX);
+    } else {
+        strLabel += PrecisionToString(nX, m_settingsXLabels.Precision());
+    }
+    strLabel += ", ";
+    strLabel += PrecisionToString(nY, m_settingsYLabels.Precision());
+    strLabel += ")";
+    return strLabel;
+}
+
+/**
+ * @brief LineChart::LinkedHoverRegion The crosshair at dX with the dot and tooltip of each series
+ */
+QRegion LineChart::LinkedHoverRegion(double dX)
+{
+    QRegion region = Chart::LinkedHoverRegion(dX);
+    int x = static_cast<int>(std::round(ConvertToPlotX(dX)));
+    for (unsigned int i = 0; i < m_vSeries.size(); i++) {
+        if (!m_vSeries[i].fShow)
+            continue;
+        //The cached points are out of date, the next paint rebuilds them
+        if (!SeriesCacheValid(i))
+            return QRegion(rect());
+
+        QPointF pointDot;
+        if (!HoverDotAt(i, x, pointDot))
+            continue;
+        region += QRect(pointDot.x() - 6, pointDot.y() - 6, 12, 12);
+        region += MouseOverTooltipRect(font(), rect(), pointDot, TooltipLabel(pointDot));
+    }
+    return region;
+}
+
+/**
+ * @brief LineChart::LinkedXRangeChanged The shared x range moved, find the visible points and their y range again
+ */
+void LineChart::LinkedXRangeChanged()
+{
+    DataChanged();
+    update();
+}
+
 void LineChart::SetFillBrush(const QBrush &brush)
 {
     m_brushFill = brush;
@@ -934,14 +1965,13 @@ void LineChart::SetVolumeBarWidth(int nWidth)
 {
     m_nBarWidth = nWidth;
     m_fChangesMade = true;
-    m_fPlotPointsDirty = true;
 }
 
 void LineChart::resizeEvent(QResizeEvent *event)
 {
     Q_UNUSED(event);
     // Mark cached points as dirty when the widget is resized
-    m_fPlotPointsDirty = true;
+    MarkAllDirty(CACHE_DIRTY_GEOMETRY);
     
     // Reset mouse tracking on resize
     m_lastMouseInChartArea = false;
@@ -973,12 +2003,6 @@ void LineChart::mouseMoveEvent(QMouseEvent *event)
     
     // Create the invalidation region for the previous mouse position
     if (m_lastMouseInChartArea) {
-        // Invalidate crosshair lines
-        updateRegion += QRect(rectChart.left(), m_lastMousePos.y() - 1, 
-                             rectChart.width(), 3); // Horizontal line
-        updateRegion += QRect(m_lastMousePos.x() - 1, rectChart.top(), 
-                             3, rectChart.height()); // Vertical line
-        
         // Invalidate all previous mouse dots and tooltips
         for (const MouseDot& dot : m_lastMouseDots) {
             QPointF dotPos = dot.Pos();
@@ -1008,52 +2032,19 @@ void LineChart::mouseMoveEvent(QMouseEvent *event)
             updateRegion += QRect(dotPos.x() - tooltipWidth/2, dotPos.y() + 5, 
                                  tooltipWidth, tooltipHeight);
         }
-        
-        // Also update Y axis label area if mouse display changes the labels
-        if (m_settingsYLabels.fEnabled) {
-            QRect yLabelArea = YLabelArea();
-            updateRegion += QRect(yLabelArea.left(), m_lastMousePos.y() - 10, 
-                                 yLabelArea.width(), 20);
-        }
-        
-        // Update X axis label area if mouse display changes the labels
-        if (m_settingsXLabels.fEnabled) {
-            QRect xLabelArea = XLabelArea();
-            updateRegion += QRect(m_lastMousePos.x() - 50, xLabelArea.top(), 
-                                 100, xLabelArea.height());
-        }
     }
     
     // Add regions for current mouse position
     if (currentInChartArea) {
-        // Crosshair lines
-        updateRegion += QRect(rectChart.left(), currentPos.y() - 1, 
-                             rectChart.width(), 3); // Horizontal line
-        updateRegion += QRect(currentPos.x() - 1, rectChart.top(), 
-                             3, rectChart.height()); // Vertical line
-        
         // Conservative estimate for potential tooltips/dots
         // Add a bit more area around current position
         updateRegion += QRect(currentPos.x() - 75, currentPos.y() - 20, 150, 40);
-        
-        // Y-axis label area for current mouse position
-        if (m_settingsYLabels.fEnabled) {
-            QRect yLabelArea = YLabelArea();
-            updateRegion += QRect(yLabelArea.left(), currentPos.y() - 10, 
-                                 yLabelArea.width(), 20);
-        }
-        
-        // X-axis label area for current mouse position
-        if (m_settingsXLabels.fEnabled) {
-            QRect xLabelArea = XLabelArea();
-            updateRegion += QRect(currentPos.x() - 50, xLabelArea.top(), 
-                                 100, xLabelArea.height());
-        }
     }
     
+    // Crosshair lines and axis labels at both positions
+    updateRegion += MoveCrossHair(currentPos, currentInChartArea);
+    
     // Store current state for next time
-    m_lastMousePos = currentPos;
-    m_lastMouseInChartArea = currentInChartArea;
     m_lastMouseDots = m_mousedisplay.GetDots();
     
     // Update only the required regions
@@ -1075,11 +2066,27 @@ void LineChart::EnableFill(bool fEnable)
     m_fChangesMade = true;
 }
 
+/**
+ * @brief LineChart::SetAutoScaleHeadroom Reserve extra space around the data when autoscaling so that the axis
+ * extents only move once the data leaves that space. While the extents stay put, new points are added to the
+ * chart without converting the existing points again, which keeps live streaming cheap. Default is 0 (fit the data).
+ * @param dYHeadroom: fraction of the y span added above and below the data
+ * @param dXHeadroom: fraction of the x span added after the newest point
+ */
+void LineChart::SetAutoScaleHeadroom(double dYHeadroom, double dXHeadroom)
+{
+    m_dYHeadroom = std::max(0.0, dYHeadroom);
+    m_dXHeadroom = std::max(0.0, dXHeadroom);
+    ProcessChangedData();
+}
+
 void LineChart::EnableVolumeBar(bool fEnable)
 {
     m_fDrawVolume = fEnable;
-    m_fChangesMade = true;
-    m_fPlotPointsDirty = true;
+
+    //The volume bars add a buffer to the bottom of the y range
+    ProcessChangedData();
+    MarkAllDirty(CACHE_DIRTY_RANGE);
 }
 
 std::vector<std::pair<QString, QColor>> LineChart::GetLegendData()
@@ -1090,4 +2097,50 @@ std::vector<std::pair<QString, QColor>> LineChart::GetLegendData()
     }
     return vLegend;
 }
+
+/**
+ * @brief LineChart::AddAnnotationPoint : Mark a single value, the annotations are drawn over the series
+ */
+void LineChart::AddAnnotationPoint(uint32_t nTime, double dValue, const QColor& color, const QString& strText)
+{
+    m_annotations.AddPoint(nTime, dValue, color, strText);
+    m_fChangesMade = true;
+    update();
+}
+
+void LineChart::AddAnnotationRect(uint32_t nTimeFirst, uint32_t nTimeLast, double dLow, double dHigh, const QColor& color, const QString& strText)
+{
+    m_annotations.AddRect(nTimeFirst, nTimeLast, dLow, dHigh, color, strText);
+    m_fChangesMade = true;
+    update();
+}
+
+void LineChart::AddAnnotationLabel(uint32_t nTime, double dValue, const QString& strText, const QColor& color)
+{
+    m_annotations.AddLabel(nTime, dValue, strText, color);
+    m_fChangesMade = true;
+    update();
+}
+
+void LineChart::AddAnnotationLine(double dValue, const QColor& color, const QString& strText)
+{
+    m_annotations.AddHorizontalLine(dValue, color, strText);
+    m_fChangesMade = true;
+    update();
+}
+
+void LineChart::ClearAnnotations()
+{
+    m_annotations.Clear();
+    m_fChangesMade = true;
+    update();
+}
+
+void LineChart::SetAnnotationMarkerSize(int nSize)
+{
+    m_annotations.SetMarkerSize(nSize);
+    m_fChangesMade = true;
+    update();
+}
+
 }//namespace
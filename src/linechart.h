@@ -26,8 +26,12 @@ SOFTWARE.
 #define LINECHART_H
 
 #include "chart.h"
+#include "annotationlayer.h"
 #include "axislabelsettings.h"
+#include "chunkedseries.h"
+#include "ingestor.h"
 #include "mousedisplay.h"
+#include "seriesview.h"
 
 #include <QBrush>
 #include <QPen>
@@ -37,6 +41,7 @@ SOFTWARE.
 #include <QWheelEvent>
 
 #include <list>
+#include <memory>
 #include <set>
 
 class QColor;
@@ -44,8 +49,17 @@ class QPaintEvent;
 class QMouseEvent;
 class QResizeEvent;
 
+namespace PssCharts {
+class SeriesModel;
+}
+
 struct LineSeries {
     std::map<uint32_t, double> data;
+    PssCharts::LineView view; //! Caller owned points, used instead of data when fExternal is set
+    bool fExternal;
+    std::shared_ptr<PssCharts::SeriesModel> model; //! Shared points, used instead of data when set
+    std::shared_ptr<PssCharts::ChunkedSeries<double>> source; //! Points written by another thread, read through snapshot when set
+    PssCharts::ChunkedSeries<double>::Snapshot snapshot; //! Version of source that is drawn until the next paint
     double priceRaw;
     bool fShow;
     QString label;
@@ -58,17 +72,49 @@ class LineChart : public Chart
     Q_OBJECT
 
 protected:
+    //! Reasons why the cached screen points of a series have to be rebuilt
+    enum CacheDirtyFlag : uint8_t {
+        CACHE_CLEAN = 0,
+        CACHE_DIRTY_DATA = 1 << 0, //! The series' own data changed
+        CACHE_DIRTY_GEOMETRY = 1 << 1, //! The chart area was resized or moved
+        CACHE_DIRTY_RANGE = 1 << 2 //! The axis extents moved
+    };
+
     std::map<std::string, std::string> m_mapProperties;
     std::vector<LineSeries> m_vSeries;
     std::vector<LineSeries> m_vVolume;
-    mutable bool m_fPlotPointsDirty;
+    std::vector<uint8_t> m_vPlotPointsDirty; // CacheDirtyFlag bits for each entry of m_cachedPlotPoints
+    std::vector<uint8_t> m_vVolumePointsDirty; // CacheDirtyFlag bits for each entry of m_cachedVolumePoints
+    QRect m_rectCachedChart; // Chart area the cached points were converted for
+    std::pair<double, double> m_pairXDataRange; // min, max of the visible data before any headroom is applied
+    std::pair<double, double> m_pairYDataRange; // min, max of the visible data before any headroom or axis buffer is applied
+    std::pair<double, double> m_pairYScaledRange; // y range with headroom applied, before the volume bar buffer
+    bool m_fHaveDataRange;
+    double m_dXHeadroom; // Fraction of the x span reserved past the newest point when autoscaling
+    double m_dYHeadroom; // Fraction of the y span reserved above and below the data when autoscaling
     std::vector<QVector<QPointF>> m_cachedPlotPoints;
     std::vector<QVector<QPointF>> m_cachedVolumePoints;
+    std::vector<std::pair<uint32_t, std::shared_ptr<Ingestor<double>>>> m_vIngestors; // Series index and the queue feeding it
+    std::vector<std::pair<uint32_t, double>> m_vIngestBuffer; // Reused between drains
+    AnnotationLayer m_annotations; // Markers and notes drawn over the series
     
     QPointF ConvertToPlotPoint(const std::pair<uint32_t, double>& pair) const;
     QPointF ConvertToVolumePoint(const std::pair<uint32_t, double>& pair) const;
     std::pair<uint32_t, double> ConvertFromPlotPoint(const QPointF& point) override;
     void UpdateCachedPoints();
+    void ConvertViewPoints(const LineView& view, size_t nFirst, size_t nLast, QVector<QPointF>& plotPoints) const;
+    void MarkSeriesDirty(const uint32_t& nSeries, uint8_t flags);
+    void MarkVolumeDirty(const uint32_t& nSeries, uint8_t flags);
+    void MarkAllDirty(uint8_t flags);
+    bool SeriesCacheValid(const uint32_t& nSeries) const;
+    void IncludeInRange(const uint32_t& x, const double& y);
+    void ApplyRange();
+    bool VolumeCacheValid(const uint32_t& nSeries) const;
+    void ReleaseModel(const uint32_t& nSeries);
+    void DisconnectModel(const SeriesModel* pModel);
+    void PinSnapshots();
+    template <typename Iterator>
+    void AppendToSeriesTail(const uint32_t& nSeries, Iterator itBegin, Iterator itEnd, bool fCacheValid);
     std::vector<QBrush> m_vLineColor; //Line color for each series
     QBrush m_brushFill;
     bool m_fEnableFill; //! Does the line get filled
@@ -79,12 +125,15 @@ protected:
     uint32_t m_nYSectionModulus;
     
     // Mouse interaction tracking
-    QPoint m_lastMousePos;
     std::vector<MouseDot> m_lastMouseDots;
-    bool m_lastMouseInChartArea;
 
-    QRect MouseOverTooltipRect(const QPainter& painter, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const;
+    QRect MouseOverTooltipRect(const QFont& fontLabel, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const;
+    bool HoverDotAt(const uint32_t& nSeries, int x, QPointF& point);
+    QString TooltipLabel(const QPointF& pointDot);
+    QRegion LinkedHoverRegion(double dX) override;
+    void LinkedXRangeChanged() override;
     void ProcessChangedData() override;
+    bool DrainIngestors() override;
 
 public:
     LineChart(QWidget* parent = nullptr);
@@ -96,6 +145,15 @@ public:
     void AddDataPoint(const uint32_t& nSeries, const uint32_t& x, const double& y);
     void RemoveDataPoint(const uint32_t& nSeries, const uint32_t& x);
     void SetDataPoints(const std::map<uint32_t, double>& mapPoints, const uint32_t& nSeries);
+    void SetDataPoints(std::map<uint32_t, double>&& mapPoints, const uint32_t& nSeries);
+    void AppendDataPoints(const uint32_t& nSeries, const std::pair<uint32_t, double>* pPoints, size_t nCount);
+    void AppendDataPoints(const uint32_t& nSeries, const std::vector<std::pair<uint32_t, double>>& vPoints);
+    void SetDataView(const LineView& view, const uint32_t& nSeries);
+    void DataViewAppended(const uint32_t& nSeries, const LineView& view);
+    void SetSeriesModel(const std::shared_ptr<SeriesModel>& model, const uint32_t& nSeries);
+    void SetSeriesSource(const std::shared_ptr<ChunkedSeries<double>>& source, const uint32_t& nSeries);
+    std::shared_ptr<Ingestor<double>> CreateIngestor(const uint32_t& nSeries, size_t nCapacity = 65536,
+                                                     IngestOverflow policy = IngestOverflow::DROP_OLDEST);
     void RemoveSeries(const uint32_t& nSeries);
     void ClearAll();
     int SeriesCount() {return m_vSeries.size();};
@@ -105,6 +163,8 @@ public:
     void AddVolumePoint(const uint32_t& nSeries, const uint32_t& x, const double& y);
     void RemoveVolumePoint(const uint32_t& nSeries, const uint32_t& x);
     void SetVolumePoints(const std::map<uint32_t, double>& mapPoints, const uint32_t& nSeries);
+    void SetVolumePoints(std::map<uint32_t, double>&& mapPoints, const uint32_t& nSeries);
+    void AppendVolumePoints(const uint32_t& nSeries, const std::pair<uint32_t, double>* pPoints, size_t nCount);
 
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
@@ -119,11 +179,28 @@ public:
     void SetLineWidth(int nWidth);
     void GetLineEquation(const QLineF& line, double& nSlope, double& nYIntercept);
     QColor GetSeriesColor(const uint32_t& nSeries) const;
+    bool ValueAt(const uint32_t& nSeries, double x, double& y) const;
+    bool NearestPoint(const uint32_t& nSeries, double x, std::pair<uint32_t, double>& point) const;
     void EnableVolumeBar(bool fEnable);
     void SetVolumeBarWidth(int nWidth);
+    void SetAutoScaleHeadroom(double dYHeadroom, double dXHeadroom = 0);
     void SetYSectionModulus(uint32_t nMod) { m_nYSectionModulus = nMod; }
     void DrawYZeroLine(bool fDraw) { m_fDrawZero = fDraw; }
     std::vector<std::pair<QString, QColor>> GetLegendData();
+    const AnnotationLayer& Annotations() const { return m_annotations; }
+    void AddAnnotationPoint(uint32_t nTime, double dValue, const QColor& color, const QString& strText = QString());
+    void AddAnnotationRect(uint32_t nTimeFirst, uint32_t nTimeLast, double dLow, double dHigh, const QColor& color, const QString& strText = QString());
+    void AddAnnotationLabel(uint32_t nTime, double dValue, const QString& strText, const QColor& color);
+    void AddAnnotationLine(double dValue, const QColor& color, const QString& strText = QString());
+    void ClearAnnotations();
+    void SetAnnotationMarkerSize(int nSize);
+
+public slots:
+    void RefreshSources();
+
+private slots:
+    void OnModelPointsAppended(uint32_t nFirstX, uint32_t nLastX);
+    void OnModelChanged();
 };
 
 } //namespace
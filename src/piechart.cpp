@@ -27,6 +27,7 @@ SOFTWARE.
 
 #include <QDateTime>
 #include <QLineF>
+#include <QMouseEvent>
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPen>
@@ -74,6 +75,12 @@ PieChart::PieChart(QWidget *parent) : Chart(ChartType::PIE, parent)
     m_rightMargin = -1;
     m_topTitleHeight = -1;
     m_precision = 100000000;
+    m_nHoverSlice = -1;
+    m_nTotal = 0;
+    m_nRatio = 0;
+    m_dOtherMinAngle = 0;
+    m_strOtherLabel = "Other";
+    m_colorOther = QColor(Qt::gray);
 
     setMouseTracking(true);
 }
@@ -142,41 +149,246 @@ QPointF PieChart::ConvertToPlotPoint(const std::pair<uint32_t, double>& pair)
     return QPoint(static_cast<int>(pointCenter.x() + (pair.second * std::sin(pair.first))), static_cast<int>(pointCenter.y() + (pair.second * std::cos(pair.second))));
 }
 
+/**
+ * @brief PieChart::InsertSlice Put a point into the slice order
+ */
+void PieChart::InsertSlice(std::map<std::string, double>::const_iterator itPoint)
+{
+    m_mapData.emplace(itPoint->second, itPoint);
+}
+
+/**
+ * @brief PieChart::EraseSlice Take a point out of the slice order. Only slices with the same value are searched.
+ */
+void PieChart::EraseSlice(std::map<std::string, double>::const_iterator itPoint)
+{
+    auto range = m_mapData.equal_range(itPoint->second);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == itPoint) {
+            m_mapData.erase(it);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief PieChart::RebuildSlices Order every point by value after the points were replaced
+ */
+void PieChart::RebuildSlices()
+{
+    m_mapData.clear();
+    for (auto it = m_mapPoints.cbegin(); it != m_mapPoints.cend(); ++it)
+        InsertSlice(it);
+    RecomputeTotal();
+}
+
+/**
+ * @brief PieChart::RecomputeTotal Sum the slices from scratch. Adding and subtracting each change to a running total would
+ * let rounding errors pile up over many updates.
+ */
+void PieChart::RecomputeTotal()
+{
+    m_nTotal = 0;
+    for (const auto& pair : m_mapData)
+        m_nTotal += pair.first;
+}
+
 void PieChart::AddDataPoint(const std::string& label, const double& value)
 {
-    m_mapPoints.emplace(label, value);
+    auto result = m_mapPoints.emplace(label, value);
     m_mapColors.emplace(label, QColor(std::rand()%256, std::rand()%256, std::rand()%256));
-    ProcessChangedData();
+    if (result.second)
+        InsertSlice(result.first);
+    DataChanged();
+}
+
+/**
+ * @brief PieChart::SetDataPoint Add a slice or change the value of an existing one. Only that slice is moved in the slice
+ * order, the other slices are left in place.
+ */
+void PieChart::SetDataPoint(const std::string& label, const double& value)
+{
+    auto it = m_mapPoints.find(label);
+    if (it == m_mapPoints.end()) {
+        AddDataPoint(label, value);
+        return;
+    }
+    if (it->second == value)
+        return;
+    EraseSlice(it);
+    it->second = value;
+    InsertSlice(it);
+    DataChanged();
 }
 
 void PieChart::RemoveDataPoint(const std::string &label)
 {
-    m_mapPoints.erase(label);
+    auto it = m_mapPoints.find(label);
+    if (it != m_mapPoints.end()) {
+        EraseSlice(it);
+        m_mapPoints.erase(it);
+    }
     m_mapColors.erase(label);
-    ProcessChangedData();
+    DataChanged();
 }
 
 void PieChart::SetDataPoints(const std::map<std::string, double>& mapPoints)
 {
-    m_mapPoints = mapPoints;
-    ProcessChangedData();
+    SetDataPoints(std::map<std::string, double>(mapPoints));
+}
+
+/**
+ * @brief PieChart::SetDataPoints Set the slices, taking ownership of the map without copying it
+ * @param mapPoints
+ */
+void PieChart::SetDataPoints(std::map<std::string, double>&& mapPoints)
+{
+    m_mapPoints = std::move(mapPoints);
+    RebuildSlices();
+    DataChanged();
 }
 
 void PieChart::ProcessChangedData()
 {
-    m_mapData.clear();
-    m_nTotal = 0;
-    for (auto pair: m_mapPoints) {
-        m_nTotal += pair.second;
-        m_mapData.emplace(std::pair<double, std::string>(pair.second, pair.first));
-    }
-    m_nRatio = 5760 / m_nTotal;
+    //The mutators keep the slice order up to date, the total and the scale that follows it are redone once per change
+    RecomputeTotal();
+    m_nRatio = m_nTotal != 0 ? 5760 / m_nTotal : 0;
     m_fChangesMade = true;
 }
 
+/**
+ * @brief PieChart::UpdateCachedSlices Lay out the slice angles, labels and repaint areas for the current data and chart area
+ */
+void PieChart::UpdateCachedSlices()
+{
+    m_vSlices.clear();
+    m_nHoverSlice = -1;
+    QRect rectChart = ChartArea();
+    m_rectCachedChart = rectChart;
+    QPoint pointCenter = rectChart.center();
+    QFont fontBold = font();
+    fontBold.setBold(true);
+    QFontMetrics fm(fontBold);
+
+    int nFilled = 0;
+    auto addSlice = [&](const std::string& strName, double dValue, const QColor& color) {
+        PieSlice slice;
+        slice.strName = strName;
+        slice.dValue = dValue;
+        slice.color = color;
+        slice.nOffset = nFilled;
+        slice.nStartAngle = static_cast<int>(m_nStartingAngle + nFilled + 5760) % 5760; // angle for start of slice
+        slice.nSpan = static_cast<int>(dValue * m_nRatio + 5760) % 5760; // angle from start of slice to end of slice
+        nFilled += slice.nSpan;
+
+        switch (m_labelType) {
+            case PieLabelType::PIE_LABEL:
+                slice.strLabel = QString::fromStdString(strName);
+                break;
+            case PieLabelType::PIE_VALUE:
+                slice.strLabel = PrecisionToString(dValue, m_settingsYLabels.Precision());
+                break;
+            case PieLabelType::PIE_LABEL_VALUE:
+                slice.strLabel = QString::fromStdString(strName) + " (" + PrecisionToString(dValue, m_settingsYLabels.Precision()) + ")";
+                break;
+            case PieLabelType::PIE_PERCENT:
+                slice.strLabel = PrecisionToString(dValue/m_nTotal*100, m_settingsYLabels.Precision()) + "%";
+                break;
+            case PieLabelType::PIE_LABEL_PERCENT:
+                slice.strLabel = QString::fromStdString(strName) + " (" + PrecisionToString(dValue/m_nTotal*100, m_settingsYLabels.Precision()) + "%)";
+                break;
+            default:
+                break;
+        }
+        double nSliceMidPoint = (90 + ((slice.nStartAngle + slice.nSpan/2) / 16)) * pi / 180;
+        QPoint pointText(pointCenter.x() + (m_xLabelPadding * m_size * std::sin(nSliceMidPoint)), pointCenter.y() + (m_yLabelPadding * m_size * std::cos(nSliceMidPoint)));
+        slice.rectLabel.setHeight(1000);
+        slice.rectLabel.setWidth(1000);
+        slice.rectLabel.moveCenter(pointText);
+
+        //The slice lies within the box of the center, its two edges and any axis crossing of its arc
+        QRect rectSlice(pointCenter, pointCenter);
+        auto addAngle = [&](int nAngle) {
+            double dRadians = nAngle / 16.0 * pi / 180;
+            QPoint pointArc(pointCenter.x() + static_cast<int>(m_size * std::cos(dRadians)), pointCenter.y() - static_cast<int>(m_size * std::sin(dRadians)));
+            rectSlice = rectSlice.united(QRect(pointArc, pointArc));
+        };
+        addAngle(slice.nStartAngle);
+        addAngle(slice.nStartAngle + slice.nSpan);
+        for (int nAxis = 0; nAxis < 2*5760; nAxis += 1440) {
+            if (nAxis > slice.nStartAngle && nAxis < slice.nStartAngle + slice.nSpan)
+                addAngle(nAxis);
+        }
+        int nMargin = m_lineWidth + 2;
+        slice.rectRepaint = rectSlice.adjusted(-nMargin, -nMargin, nMargin, nMargin);
+        QRect rectText = fm.boundingRect(slice.strLabel);
+        rectText.moveCenter(pointText);
+        if (!slice.strLabel.isEmpty())
+            slice.rectRepaint = slice.rectRepaint.united(rectText.adjusted(-1, -1, 1, 1));
+        m_vSlices.emplace_back(slice);
+    };
+
+    size_t nRemaining = m_mapData.size();
+    double dRemaining = m_nTotal;
+    for (const auto& pair : m_mapData) {
+        //Slices come largest first, so once one is under the threshold the rest of the tail goes into the other slice
+        if (m_dOtherMinAngle > 0 && nRemaining > 1 && pair.first * m_nRatio < m_dOtherMinAngle * 16) {
+            addSlice(m_strOtherLabel, dRemaining, m_colorOther);
+            break;
+        }
+        const std::string& strName = pair.second->first;
+        auto itColor = m_mapColors.find(strName);
+        addSlice(strName, pair.first, itColor != m_mapColors.end() ? itColor->second : QColor());
+        dRemaining -= pair.first;
+        nRemaining--;
+    }
+}
+
+/**
+ * @brief PieChart::SliceIndexAt The slice under a point, found with one atan2 and a binary search over the slice offsets
+ * @return -1 if the point is not on a slice
+ */
+int PieChart::SliceIndexAt(const QPoint& point) const
+{
+    if (m_vSlices.empty())
+        return -1;
+    QPoint pointCenter = m_rectCachedChart.center();
+    double dx = point.x() - pointCenter.x();
+    double dy = pointCenter.y() - point.y();
+    if (dx*dx + dy*dy >= static_cast<double>(m_size) * m_size)
+        return -1;
+
+    int nAngle = static_cast<int>(std::atan2(dy, dx) * 180 / pi * 16);
+    int nOffset = ((nAngle - m_nStartingAngle) % 5760 + 5760) % 5760;
+    auto it = std::lower_bound(m_vSlices.begin(), m_vSlices.end(), nOffset,
+                               [](const PieSlice& slice, int nOffset) { return slice.nOffset + slice.nSpan < nOffset; });
+    if (it == m_vSlices.end() || nOffset <= it->nOffset)
+        return -1;
+    return static_cast<int>(it - m_vSlices.begin());
+}
+
+QRect PieChart::SliceRepaintRect(int nSlice) const
+{
+    if (nSlice < 0 || static_cast<size_t>(nSlice) >= m_vSlices.size())
+        return QRect();
+    return m_vSlices[nSlice].rectRepaint;
+}
+
+/**
+ * @brief PieChart::SliceAt The name and value of the slice under a point. Uses the slice layout of the last paint.
+ * @return false if the point is not on a slice
+ */
+bool PieChart::SliceAt(const QPoint& point, std::pair<std::string, double>& slice) const
+{
+    int nSlice = SliceIndexAt(point);
+    if (nSlice < 0)
+        return false;
+    slice = std::make_pair(m_vSlices[nSlice].strName, m_vSlices[nSlice].dValue);
+    return true;
+}
+
 void PieChart::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
 
     //Fill in the background first
     QPainter painter(this);
@@ -226,83 +438,39 @@ void PieChart::paintEvent(QPaintEvent *event)
     rectPie.setTop(pointCenter.y() + m_size);
     rectPie.setRight(pointCenter.x() - m_size);
     rectPie.setLeft(pointCenter.x() + m_size);
-    double nFilled = 0;
     int nHighlightStartAngle = 0;
     int nHighlightSpan = 0;
-    bool fDrawHighlight = false;
-    for(auto pair: m_mapData) {
+
+    //The slice layout depends on the data, settings and chart area, hover alone only changes which slice is highlighted
+    if (m_fChangesMade || rectChart != m_rectCachedChart)
+        UpdateCachedSlices();
+    m_nHoverSlice = SliceIndexAt(lposMouse);
+    bool fDrawHighlight = m_nHoverSlice >= 0;
+    if (fDrawHighlight) {
+        nHighlightStartAngle = m_vSlices[m_nHoverSlice].nStartAngle;
+        nHighlightSpan = m_vSlices[m_nHoverSlice].nSpan;
+    }
+
+    bool fFullPaint = event->region().contains(rectChart);
+    for (size_t i = 0; i < m_vSlices.size(); i++) {
+        //Partial repaint, usually a hover change, so only the slices inside the dirty area are drawn
+        const PieSlice& slice = m_vSlices[i];
+        if (!fFullPaint && !event->region().intersects(slice.rectRepaint))
+            continue;
+
         // Draw Pie Slice
         painter.setPen(penLine);
-        std::pair<uint32_t, double> mouseData = ConvertFromPlotPoint(lposMouse);
-        int mouseAngle = static_cast<int>(mouseData.first);
-        mouseAngle = (mouseAngle + 5760) % 5760; // prevents negative angles in calculation
-        int nSliceStartingAngle = static_cast<int>(m_nStartingAngle + nFilled + 5760) % 5760; // angle for start of slice
-        int nSliceSpan = static_cast<int>(pair.first * m_nRatio + 5760) % 5760; // angle from start of slice to end of slice
-        int nSliceEndingAngle = static_cast<int>(nSliceStartingAngle + nSliceSpan + 5760) % 5760; // angle for end of slice
-        // Check if end angle is set properly after modulo
-        if (nSliceStartingAngle > nSliceEndingAngle) {
-            nSliceEndingAngle += 5760;
-        }
-        int mouseDistance = static_cast<int>(mouseData.second);
-        bool fHighlightText = false;
         if (m_fEnableFill) {
-            painter.setBrush(m_mapColors[pair.second]);
+            painter.setBrush(slice.color);
         }
-        // Highlight data
-        if (mouseAngle > nSliceStartingAngle && mouseAngle <= nSliceEndingAngle && mouseDistance < m_size) {
-            fDrawHighlight = true;
-            fHighlightText = true;
-            nHighlightStartAngle = nSliceStartingAngle;
-            nHighlightSpan = nSliceSpan;
-        }
-        painter.drawPie(rectPie, nSliceStartingAngle, nSliceSpan);
-        nFilled += nSliceSpan;
+        painter.drawPie(rectPie, slice.nStartAngle, slice.nSpan);
 
         // Draw Pie Label
-        QRect rectText;
-        double nSliceMidPoint = (90 + ((nSliceStartingAngle + nSliceSpan/2) / 16)) * pi / 180;
-        QPoint pointText(pointCenter.x() + (m_xLabelPadding * m_size * std::sin(nSliceMidPoint)), pointCenter.y() + (m_yLabelPadding * m_size * std::cos(nSliceMidPoint)));
-        rectText.setHeight(1000);
-        rectText.setWidth(1000);
-        rectText.moveCenter(pointText);
-        QString strLabel;
         painter.setPen(m_colorYTitle);
-        switch (m_labelType) {
-            case PieLabelType::PIE_LABEL: {
-                strLabel = QString::fromStdString(pair.second);
-                break;
-            }
-            case PieLabelType::PIE_VALUE: {
-                strLabel = PrecisionToString(pair.first, m_settingsYLabels.Precision());
-                break;
-            }
-            case PieLabelType::PIE_LABEL_VALUE: {
-                strLabel = QString::fromStdString(pair.second) + " (" + PrecisionToString(pair.first, m_settingsYLabels.Precision()) + ")";
-                break;
-            }
-            case PieLabelType::PIE_PERCENT: {
-                strLabel = PrecisionToString(pair.first/m_nTotal*100, m_settingsYLabels.Precision()) + "%";
-                break;
-            }
-            case PieLabelType::PIE_LABEL_PERCENT: {
-                strLabel = QString::fromStdString(pair.second) + " (" + PrecisionToString(pair.first/m_nTotal*100, m_settingsYLabels.Precision()) + "%)";
-                break;
-            }
-            default:
-                strLabel = "";
-                break;
-        }
-        if (fHighlightText) {
-            QFont font = painter.font();
-            font.setBold(true);
-            painter.setFont(font);
-            painter.drawText(rectText, Qt::AlignCenter, strLabel);
-        } else {
-            QFont font = painter.font();
-            font.setBold(false);
-            painter.setFont(font);
-            painter.drawText(rectText, Qt::AlignCenter, strLabel);
-        }
+        QFont font = painter.font();
+        font.setBold(static_cast<int>(i) == m_nHoverSlice);
+        painter.setFont(font);
+        painter.drawText(slice.rectLabel, Qt::AlignCenter, slice.strLabel);
     }
 
     // Draw Highlight
@@ -375,6 +543,53 @@ void PieChart::paintEvent(QPaintEvent *event)
     m_fChangesMade = false;
 }
 
+/**
+ * @brief PieChart::mouseMoveEvent Repaint only what the mouse changed: the previously and newly highlighted slices, and the
+ * cross hair when the mouse display is enabled.
+ */
+void PieChart::mouseMoveEvent(QMouseEvent *event)
+{
+    QRect rectChart = ChartArea();
+    if (m_fChangesMade || rectChart != m_rectCachedChart) {
+        //The cached slices are out of date, the next paint rebuilds them
+        Chart::mouseMoveEvent(event);
+        return;
+    }
+
+    QPoint pos = event->pos();
+    bool fInChartArea = rectChart.contains(pos);
+    int nHoverSlice = SliceIndexAt(pos);
+
+    QRegion updateRegion;
+    if (nHoverSlice != m_nHoverSlice) {
+        updateRegion += SliceRepaintRect(m_nHoverSlice);
+        updateRegion += SliceRepaintRect(nHoverSlice);
+    }
+    updateRegion += MoveCrossHair(pos, fInChartArea);
+
+    m_nHoverSlice = nHoverSlice;
+    if (!updateRegion.isEmpty())
+        update(updateRegion);
+
+    //Chart::mouseMoveEvent would repaint the whole chart
+    QWidget::mouseMoveEvent(event);
+}
+
+/**
+ * @brief PieChart::SetOtherSlice Fold the slices that would span less than a minimum angle into one slice, so a long tail of
+ * small values is drawn and labeled once instead of as many slivers.
+ * @param dMinDegrees: Smallest slice that is drawn on its own, 0 draws every slice
+ * @param strLabel: Name of the folded slice
+ * @param color: Color of the folded slice
+ */
+void PieChart::SetOtherSlice(double dMinDegrees, const std::string& strLabel, const QColor& color)
+{
+    m_dOtherMinAngle = dMinDegrees;
+    m_strOtherLabel = strLabel;
+    m_colorOther = color;
+    m_fChangesMade = true;
+}
+
 void PieChart::SetLineBrush(const QBrush &brush)
 {
     m_brushLine = brush;
@@ -482,7 +697,7 @@ std::map<std::string, QColor> PieChart::GetColorMap() {
 
 std::vector<std::pair<QString, QColor>> PieChart::GetLegendData() {
     std::vector<std::pair<QString, QColor>> vLegendData;
-    for(auto pair : m_mapColors) {
+    for(const auto& pair : m_mapColors) {
         vLegendData.emplace_back(std::make_pair(QString::fromStdString(pair.first), pair.second));
     }
     return vLegendData;
@@ -494,7 +709,7 @@ std::vector<std::pair<QString, QColor>> PieChart::GetLegendData() {
  */
 QStringList PieChart::ChartLabels() {
     QStringList listLabels;
-    for (auto pair: m_mapPoints) {
+    for (const auto& pair: m_mapPoints) {
         listLabels.append(QString::fromStdString(pair.first));
     }
     return listLabels;
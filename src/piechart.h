@@ -40,6 +40,7 @@ SOFTWARE.
 #include <set>
 #include <cmath>
 class QColor;
+class QMouseEvent;
 class QPaintEvent;
 
 namespace PssCharts {
@@ -66,10 +67,27 @@ class PieChart : public Chart
     };
 
 protected:
+    //! Screen geometry of a slice, kept until the data, settings or chart area change
+    struct PieSlice {
+        std::string strName;
+        double dValue;
+        int nOffset; //! Angle from the starting angle of the chart to the start of the slice
+        int nStartAngle;
+        int nSpan;
+        QColor color;
+        QString strLabel;
+        QRect rectLabel; //! Rect the label is centered in
+        QRect rectRepaint; //! Area covered by the slice, its outline and its label
+    };
+
     double pi = 3.141592653589793;
 
     std::map<std::string, double> m_mapPoints;
-    std::multimap<double, std::string, cmpGreaterKey> m_mapData;
+    std::multimap<double, std::map<std::string, double>::const_iterator, cmpGreaterKey> m_mapData; //! Points ordered by value, largest first
+    void InsertSlice(std::map<std::string, double>::const_iterator itPoint);
+    void EraseSlice(std::map<std::string, double>::const_iterator itPoint);
+    void RebuildSlices();
+    void RecomputeTotal();
     std::pair<uint32_t, double> ConvertFromPlotPoint(const QPointF& point) override;
     QPointF ConvertToPlotPoint(const std::pair<uint32_t, double>& pair);
     std::map<std::string, QColor> m_mapColors;
@@ -83,6 +101,9 @@ protected:
     int m_nStartingAngle;
     double m_nTotal;
     double m_nRatio;
+    double m_dOtherMinAngle; //! Slices narrower than this many degrees are folded into the other slice, 0 to disable
+    std::string m_strOtherLabel;
+    QColor m_colorOther;
     bool m_fEnableOutline;
     double m_xLabelPadding;
     double m_yLabelPadding;
@@ -92,18 +113,29 @@ protected:
     bool m_fEnableHighlightOutline;
     QColor m_colorHighlightOutline;
 
+    std::vector<PieSlice> m_vSlices; //! Slices in drawing order, so their offsets are increasing
+    QRect m_rectCachedChart; //! Chart area the slices were laid out for
+    int m_nHoverSlice; //! Index of the highlighted slice, -1 for none
+    void UpdateCachedSlices();
+    int SliceIndexAt(const QPoint& point) const;
+    QRect SliceRepaintRect(int nSlice) const;
+
     QRect MouseOverTooltipRect(const QPainter& painter, const QRect& rectFull, const QPointF& pointCircleCenter, const QString& strLabel) const;
     void ProcessChangedData() override;
+    void mouseMoveEvent(QMouseEvent *event) override;
 
 public:
     PieChart(QWidget* parent = nullptr);
     void paintEvent(QPaintEvent *event) override;
     QRect ChartArea() const;
     QStringList ChartLabels();
+    bool SliceAt(const QPoint& point, std::pair<std::string, double>& slice) const;
 
     void AddDataPoint(const std::string& label, const double& value);
+    void SetDataPoint(const std::string& label, const double& value);
     void RemoveDataPoint(const std::string& label);
     void SetDataPoints(const std::map<std::string, double>& mapPoints);
+    void SetDataPoints(std::map<std::string, double>&& mapPoints);
 
     void EnableFill(bool fEnable);
     void SetLineBrush(const QBrush& brush);
@@ -117,6 +149,7 @@ public:
     void SetLabelType(std::string nType);
     void SetXLabelPadding(double nPadding);
     void SetYLabelPadding(double nPadding);
+    void SetOtherSlice(double dMinDegrees, const std::string& strLabel = "Other", const QColor& color = QColor(Qt::gray));
 
     QColor GetColor(std::string label);
     void SetColor(std::string label, QColor qColor);
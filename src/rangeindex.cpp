@@ -0,0 +1,238 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "rangeindex.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace PssCharts {
+
+void RangeMinMax::Merge(std::pair<double, double>& pairInto, const std::pair<double, double>& pair)
+{
+    pairInto.first = std::min(pairInto.first, pair.first);
+    pairInto.second = std::max(pairInto.second, pair.second);
+}
+
+void RangeMinMax::Clear()
+{
+    m_vLevels.clear();
+}
+
+void RangeMinMax::Reserve(size_t nSize)
+{
+    if (m_vLevels.empty())
+        m_vLevels.emplace_back();
+    m_vLevels[0].reserve(nSize);
+}
+
+/**
+ * @brief RangeMinMax::Append: Add a pair to the end of the sequence
+ */
+void RangeMinMax::Append(double dMin, double dMax)
+{
+    std::pair<double, double> pair(dMin, dMax);
+    if (m_vLevels.empty())
+        m_vLevels.emplace_back();
+    m_vLevels[0].emplace_back(pair);
+
+    size_t nIndex = m_vLevels[0].size() - 1;
+    for (size_t nLevel = 0; m_vLevels[nLevel].size() > 1; nLevel++) {
+        if (nLevel + 1 == m_vLevels.size()) {
+            //The top level just got its second entry, so it needs a level above it
+            std::pair<double, double> pairTop = m_vLevels[nLevel][0];
+            Merge(pairTop, m_vLevels[nLevel][1]);
+            m_vLevels.emplace_back(1, pairTop);
+            break;
+        }
+        nIndex /= FANOUT;
+        std::vector<std::pair<double, double>>& vParent = m_vLevels[nLevel + 1];
+        if (nIndex == vParent.size())
+            vParent.emplace_back(pair);
+        else
+            Merge(vParent[nIndex], pair);
+    }
+}
+
+/**
+ * @brief RangeMinMax::Set: Replace the pair at an index. The entries above it are recomputed, since the new pair may be narrower.
+ */
+void RangeMinMax::Set(size_t nIndex, double dMin, double dMax)
+{
+    if (nIndex >= Size())
+        return;
+    m_vLevels[0][nIndex] = std::make_pair(dMin, dMax);
+    for (size_t nLevel = 0; nLevel + 1 < m_vLevels.size(); nLevel++) {
+        const std::vector<std::pair<double, double>>& vLevel = m_vLevels[nLevel];
+        nIndex /= FANOUT;
+        size_t nFirst = nIndex * FANOUT;
+        size_t nLast = std::min(nFirst + FANOUT, vLevel.size());
+        std::pair<double, double> pairParent = vLevel[nFirst];
+        for (size_t i = nFirst + 1; i < nLast; i++)
+            Merge(pairParent, vLevel[i]);
+        m_vLevels[nLevel + 1][nIndex] = pairParent;
+    }
+}
+
+/**
+ * @brief RangeMinMax::Query: Combined pair of the entries in [nFirst, nLast)
+ * @return false if the range is empty
+ */
+bool RangeMinMax::Query(size_t nFirst, size_t nLast, double& dMin, double& dMax) const
+{
+    nLast = std::min(nLast, Size());
+    if (nFirst >= nLast)
+        return false;
+
+    std::pair<double, double> pairResult = m_vLevels[0][nFirst];
+    for (size_t nLevel = 0; nFirst < nLast; nLevel++) {
+        const std::vector<std::pair<double, double>>& vLevel = m_vLevels[nLevel];
+        //Read the unaligned ends on this level, the aligned middle is covered by the level above
+        while (nFirst < nLast && nFirst % FANOUT != 0)
+            Merge(pairResult, vLevel[nFirst++]);
+        while (nFirst < nLast && nLast % FANOUT != 0)
+            Merge(pairResult, vLevel[--nLast]);
+        if (nFirst < nLast && nLevel + 1 == m_vLevels.size()) {
+            //Only happens on a single level sequence
+            while (nFirst < nLast)
+                Merge(pairResult, vLevel[nFirst++]);
+        }
+        nFirst /= FANOUT;
+        nLast /= FANOUT;
+    }
+    dMin = pairResult.first;
+    dMax = pairResult.second;
+    return true;
+}
+
+//! Revisions are unique across all indexes, so a cache keyed on an index can not mistake a reused address for the same points
+static std::atomic<uint64_t> g_nSeriesIndexRevision(0);
+
+SeriesIndex::SeriesIndex()
+{
+    m_vPrefixSum.emplace_back(0);
+    m_nRevision = ++g_nSeriesIndexRevision;
+}
+
+void SeriesIndex::Clear()
+{
+    m_vTime.clear();
+    m_vPrefixSum.assign(1, 0);
+    m_rangeValues.Clear();
+    m_nRevision = ++g_nSeriesIndexRevision;
+}
+
+void SeriesIndex::Reserve(size_t nSize)
+{
+    m_vTime.reserve(nSize);
+    m_vPrefixSum.reserve(nSize + 1);
+    m_rangeValues.Reserve(nSize);
+}
+
+/**
+ * @brief SeriesIndex::Append: Add a point to the end of the series
+ * @return false if the point is not newer than the last point, the index is left unchanged
+ */
+bool SeriesIndex::Append(uint32_t nTime, double dValue)
+{
+    if (!m_vTime.empty() && nTime <= m_vTime.back())
+        return false;
+    m_vTime.emplace_back(nTime);
+    m_vPrefixSum.emplace_back(m_vPrefixSum.back() + dValue);
+    m_rangeValues.Append(dValue, dValue);
+    return true;
+}
+
+void SeriesIndex::Assign(const std::map<uint32_t, double>& mapPoints)
+{
+    Clear();
+    Reserve(mapPoints.size());
+    for (const auto& pair : mapPoints)
+        Append(pair.first, pair.second);
+}
+
+/**
+ * @brief SeriesIndex::IndexRange: The index range [nFirst, nLast) of the points with a time in [nStart, nEnd]
+ */
+void SeriesIndex::IndexRange(uint32_t nStart, uint32_t nEnd, size_t& nFirst, size_t& nLast) const
+{
+    nFirst = std::lower_bound(m_vTime.begin(), m_vTime.end(), nStart) - m_vTime.begin();
+    nLast = std::upper_bound(m_vTime.begin(), m_vTime.end(), nEnd) - m_vTime.begin();
+    if (nLast < nFirst)
+        nLast = nFirst;
+}
+
+double SeriesIndex::SumAt(size_t nFirst, size_t nLast) const
+{
+    nLast = std::min(nLast, Size());
+    if (nFirst >= nLast)
+        return 0;
+    return m_vPrefixSum[nLast] - m_vPrefixSum[nFirst];
+}
+
+bool SeriesIndex::MinMaxAt(size_t nFirst, size_t nLast, double& dMin, double& dMax) const
+{
+    return m_rangeValues.Query(nFirst, nLast, dMin, dMax);
+}
+
+size_t SeriesIndex::Count(uint32_t nStart, uint32_t nEnd) const
+{
+    size_t nFirst, nLast;
+    IndexRange(nStart, nEnd, nFirst, nLast);
+    return nLast - nFirst;
+}
+
+double SeriesIndex::Sum(uint32_t nStart, uint32_t nEnd) const
+{
+    size_t nFirst, nLast;
+    IndexRange(nStart, nEnd, nFirst, nLast);
+    return SumAt(nFirst, nLast);
+}
+
+/**
+ * @brief SeriesIndex::Mean: Mean value of the points with a time in [nStart, nEnd]
+ * @return false if there are no points in the range
+ */
+bool SeriesIndex::Mean(uint32_t nStart, uint32_t nEnd, double& dMean) const
+{
+    size_t nFirst, nLast;
+    IndexRange(nStart, nEnd, nFirst, nLast);
+    if (nFirst == nLast)
+        return false;
+    dMean = SumAt(nFirst, nLast) / (nLast - nFirst);
+    return true;
+}
+
+/**
+ * @brief SeriesIndex::MinMax: Smallest and largest value of the points with a time in [nStart, nEnd]
+ * @return false if there are no points in the range
+ */
+bool SeriesIndex::MinMax(uint32_t nStart, uint32_t nEnd, double& dMin, double& dMax) const
+{
+    size_t nFirst, nLast;
+    IndexRange(nStart, nEnd, nFirst, nLast);
+    return MinMaxAt(nFirst, nLast, dMin, dMax);
+}
+
+} //namespace
@@ -0,0 +1,99 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace PssCharts {
+
+/**
+ * @brief RangeMinMax: Smallest minimum and largest maximum over any index range of a sequence of (min, max) pairs.
+ * Level 0 holds the pairs and every level above holds the combined pair of FANOUT entries of the level below, so a query
+ * reads at most 2 * FANOUT entries per level. Appending and changing an entry only touch the entries above it.
+ */
+class RangeMinMax
+{
+public:
+    static const size_t FANOUT = 16;
+
+private:
+    std::vector<std::vector<std::pair<double, double>>> m_vLevels;
+
+    static void Merge(std::pair<double, double>& pairInto, const std::pair<double, double>& pair);
+
+public:
+    size_t Size() const { return m_vLevels.empty() ? 0 : m_vLevels[0].size(); }
+    bool Empty() const { return Size() == 0; }
+    void Clear();
+    void Reserve(size_t nSize);
+    void Append(double dMin, double dMax);
+    void Set(size_t nIndex, double dMin, double dMax);
+    bool Query(size_t nFirst, size_t nLast, double& dMin, double& dMax) const;
+};
+
+/**
+ * @brief SeriesIndex: Range aggregates of a time ordered series. Prefix sums answer the sum, count and mean of any time range
+ * in O(log n) for finding the range and O(1) after that, and a RangeMinMax answers its min and max in O(log n).
+ * Appending a point newer than the last one extends the index in O(1) amortized.
+ */
+class SeriesIndex
+{
+private:
+    std::vector<uint32_t> m_vTime;
+    std::vector<double> m_vPrefixSum; //! Sum of the values before each index, one entry longer than the series
+    RangeMinMax m_rangeValues;
+    uint64_t m_nRevision; //! Changes whenever existing points are replaced, appends only change the size
+
+public:
+    SeriesIndex();
+
+    size_t Size() const { return m_vTime.size(); }
+    bool Empty() const { return m_vTime.empty(); }
+    uint32_t Time(size_t nIndex) const { return m_vTime[nIndex]; }
+    uint64_t Revision() const { return m_nRevision; }
+    void Clear();
+    void Reserve(size_t nSize);
+    bool Append(uint32_t nTime, double dValue);
+    void Assign(const std::map<uint32_t, double>& mapPoints);
+
+    //Queries on index ranges [nFirst, nLast)
+    void IndexRange(uint32_t nStart, uint32_t nEnd, size_t& nFirst, size_t& nLast) const;
+    double SumAt(size_t nFirst, size_t nLast) const;
+    bool MinMaxAt(size_t nFirst, size_t nLast, double& dMin, double& dMax) const;
+
+    //Queries on time ranges [nStart, nEnd]
+    size_t Count(uint32_t nStart, uint32_t nEnd) const;
+    double Sum(uint32_t nStart, uint32_t nEnd) const;
+    bool Mean(uint32_t nStart, uint32_t nEnd, double& dMean) const;
+    bool MinMax(uint32_t nStart, uint32_t nEnd, double& dMin, double& dMax) const;
+};
+
+} //namespace
+#endif // RANGEINDEX_H
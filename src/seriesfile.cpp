@@ -0,0 +1,501 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "seriesfile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace PssCharts {
+
+static const char SERIESFILE_MAGIC[4] = {'P', 'S', 'S', 'F'};
+static const size_t WRITE_CHUNK = 1 << 16;
+
+static uint64_t AlignUp(uint64_t n)
+{
+    return (n + 7) & ~static_cast<uint64_t>(7);
+}
+
+/**
+ * @brief BufferedWriter: Collects the small per-element writes of a column into large file writes
+ */
+class BufferedWriter
+{
+    QFile& m_file;
+    std::vector<char> m_vBuffer;
+    bool m_fOk;
+
+public:
+    explicit BufferedWriter(QFile& file) : m_file(file), m_fOk(true)
+    {
+        m_vBuffer.reserve(WRITE_CHUNK);
+    }
+
+    void PutBytes(const char* pData, size_t nSize)
+    {
+        m_vBuffer.insert(m_vBuffer.end(), pData, pData + nSize);
+        if (m_vBuffer.size() >= WRITE_CHUNK)
+            Flush();
+    }
+
+    template <typename T>
+    void Put(const T& value)
+    {
+        PutBytes(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    bool Flush()
+    {
+        if (!m_vBuffer.empty() && m_file.write(m_vBuffer.data(), m_vBuffer.size()) != static_cast<qint64>(m_vBuffer.size()))
+            m_fOk = false;
+        m_vBuffer.clear();
+        return m_fOk;
+    }
+};
+
+//! Write zeros until the file position reaches nOffset
+static bool PadTo(QFile& file, uint64_t nOffset)
+{
+    static const char zeros[8] = {0};
+    qint64 nPos = file.pos();
+    while (static_cast<uint64_t>(nPos) < nOffset) {
+        qint64 nWrite = std::min<qint64>(sizeof(zeros), nOffset - nPos);
+        if (file.write(zeros, nWrite) != nWrite)
+            return false;
+        nPos += nWrite;
+    }
+    return true;
+}
+
+//! Add one row to the flat {min, max} block index
+static void IncludeInIndex(std::vector<double>& vIndex, uint64_t nRow, uint32_t nBlockRows, double dLow, double dHigh)
+{
+    if (nBlockRows == 0)
+        return;
+    if (nRow % nBlockRows == 0) {
+        vIndex.emplace_back(dLow);
+        vIndex.emplace_back(dHigh);
+        return;
+    }
+    double& dMin = vIndex[vIndex.size() - 2];
+    double& dMax = vIndex[vIndex.size() - 1];
+    dMin = std::min(dMin, dLow);
+    dMax = std::max(dMax, dHigh);
+}
+
+//! Width of one element of a column, the views read every column at exactly this width
+static uint32_t ColumnElementSize(uint32_t nType)
+{
+    switch (nType) {
+    case SeriesFile::COLUMN_TIME:
+    case SeriesFile::COLUMN_LABEL_OFFSET:
+        return sizeof(uint32_t);
+    case SeriesFile::COLUMN_LABEL_DATA:
+        return sizeof(char);
+    default:
+        return sizeof(double);
+    }
+}
+
+SeriesFile::SeriesFile()
+{
+    m_pMap = nullptr;
+    m_nMapSize = 0;
+    m_kind = Kind::NONE;
+    m_nRows = 0;
+    m_nBlockRows = 0;
+    m_pIndex = nullptr;
+}
+
+SeriesFile::~SeriesFile()
+{
+    Close();
+}
+
+bool SeriesFile::Fail(const QString& strError)
+{
+    m_strError = strError;
+    Close();
+    return false;
+}
+
+/**
+ * @brief SeriesFile::Open: Map a series file and validate its layout. No data is read beyond the header and column table.
+ * @return false if the file can not be mapped or is not a valid series file, see ErrorString()
+ */
+bool SeriesFile::Open(const QString& strPath)
+{
+    Close();
+    m_strError.clear();
+    m_file.setFileName(strPath);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return Fail(m_file.errorString());
+
+    m_nMapSize = m_file.size();
+    if (m_nMapSize < static_cast<qint64>(sizeof(SeriesFileHeader)))
+        return Fail("File is too small to be a series file");
+    m_pMap = m_file.map(0, m_nMapSize);
+    if (!m_pMap)
+        return Fail(m_file.errorString());
+
+    SeriesFileHeader header;
+    memcpy(&header, m_pMap, sizeof(header));
+    if (memcmp(header.magic, SERIESFILE_MAGIC, sizeof(SERIESFILE_MAGIC)) != 0)
+        return Fail("Not a series file");
+    if (header.nVersion != VERSION)
+        return Fail("Unsupported series file version");
+    if (header.nKind < static_cast<uint16_t>(Kind::LINE) || header.nKind > static_cast<uint16_t>(Kind::PIE))
+        return Fail("Unknown series file kind");
+    if (header.nRows > std::numeric_limits<size_t>::max())
+        return Fail("Series file has too many rows for this platform");
+
+    uint64_t nFileSize = static_cast<uint64_t>(m_nMapSize);
+    uint64_t nTableEnd = sizeof(SeriesFileHeader) + static_cast<uint64_t>(header.nColumns) * sizeof(SeriesFileColumn);
+    if (nTableEnd > nFileSize)
+        return Fail("Column table is truncated");
+
+    m_vColumns.assign(COLUMN_TYPE_COUNT, nullptr);
+    m_vColumnCount.assign(COLUMN_TYPE_COUNT, 0);
+    for (uint32_t i = 0; i < header.nColumns; i++) {
+        SeriesFileColumn column;
+        memcpy(&column, m_pMap + sizeof(SeriesFileHeader) + i * sizeof(SeriesFileColumn), sizeof(column));
+        if (column.nType == 0 || column.nType >= COLUMN_TYPE_COUNT || column.nElementSize == 0)
+            continue; //Columns added by newer writers are skipped
+        if (column.nElementSize != ColumnElementSize(column.nType))
+            return Fail("Column has the wrong element size for its type");
+        if (column.nOffset % 8 != 0)
+            return Fail("Column is not aligned");
+
+        //LABEL_OFFSET holds one extra entry and LABEL_DATA is sized by the last offset, everything else has one entry per row
+        uint64_t nCount = header.nRows;
+        if (column.nType == COLUMN_LABEL_OFFSET)
+            nCount = header.nRows + 1;
+        if (column.nType == COLUMN_LABEL_DATA)
+            nCount = (nFileSize - std::min(column.nOffset, nFileSize)) / column.nElementSize;
+        if (column.nOffset < nTableEnd || column.nOffset > nFileSize || nCount > (nFileSize - column.nOffset) / column.nElementSize)
+            return Fail("Column is outside of the file");
+
+        m_vColumns[column.nType] = m_pMap + column.nOffset;
+        m_vColumnCount[column.nType] = nCount;
+    }
+
+    m_kind = static_cast<Kind>(header.nKind);
+    std::vector<ColumnType> vRequired;
+    if (m_kind == Kind::LINE)
+        vRequired = {COLUMN_TIME, COLUMN_VALUE};
+    else if (m_kind == Kind::CANDLE)
+        vRequired = {COLUMN_TIME, COLUMN_OPEN, COLUMN_HIGH, COLUMN_LOW, COLUMN_CLOSE};
+    else if (m_kind == Kind::PIE)
+        vRequired = {COLUMN_VALUE, COLUMN_LABEL_OFFSET, COLUMN_LABEL_DATA};
+    else
+        return Fail("Unknown series file kind");
+    for (ColumnType type : vRequired) {
+        if (!m_vColumns[type])
+            return Fail("Series file is missing a required column");
+    }
+
+    if (header.nBlockRows > 0 && header.nIndexOffset > 0) {
+        uint64_t nBlocks = (header.nRows + header.nBlockRows - 1) / header.nBlockRows;
+        if (header.nIndexOffset % 8 != 0 || header.nIndexOffset > nFileSize
+                || nBlocks > (nFileSize - header.nIndexOffset) / (2 * sizeof(double)))
+            return Fail("Block index is outside of the file");
+        m_pIndex = reinterpret_cast<const double*>(m_pMap + header.nIndexOffset);
+        m_nBlockRows = header.nBlockRows;
+    }
+    m_nRows = header.nRows;
+    return true;
+}
+
+void SeriesFile::Close()
+{
+    if (m_pMap)
+        m_file.unmap(m_pMap);
+    m_file.close();
+    m_pMap = nullptr;
+    m_nMapSize = 0;
+    m_kind = Kind::NONE;
+    m_nRows = 0;
+    m_nBlockRows = 0;
+    m_pIndex = nullptr;
+    m_vColumns.clear();
+    m_vColumnCount.clear();
+}
+
+/**
+ * @brief SeriesFile::Series: View of a line file's points, reading straight from the mapping
+ */
+LineView SeriesFile::Series() const
+{
+    if (m_kind != Kind::LINE)
+        return LineView();
+    LineView view(Column<uint32_t>(COLUMN_TIME), Column<double>(COLUMN_VALUE), m_nRows);
+    if (m_pIndex)
+        view.SetRangeIndex(this);
+    return view;
+}
+
+/**
+ * @brief SeriesFile::Candles: View of a candle file's candles, reading straight from the mapping
+ */
+CandleView SeriesFile::Candles() const
+{
+    if (m_kind != Kind::CANDLE)
+        return CandleView();
+    CandleView view(Column<uint32_t>(COLUMN_TIME), Column<double>(COLUMN_OPEN), Column<double>(COLUMN_HIGH),
+                    Column<double>(COLUMN_LOW), Column<double>(COLUMN_CLOSE), Column<double>(COLUMN_VOLUME), m_nRows);
+    if (m_pIndex)
+        view.SetRangeIndex(this);
+    return view;
+}
+
+/**
+ * @brief SeriesFile::PieData: The slices of a pie file. Pie charts hold a handful of labelled slices, so they are copied out.
+ */
+std::map<std::string, double> SeriesFile::PieData() const
+{
+    std::map<std::string, double> mapPoints;
+    if (m_kind != Kind::PIE)
+        return mapPoints;
+
+    const double* pValues = Column<double>(COLUMN_VALUE);
+    const uint32_t* pOffsets = Column<uint32_t>(COLUMN_LABEL_OFFSET);
+    const char* pLabels = Column<char>(COLUMN_LABEL_DATA);
+    uint64_t nLabelBytes = m_vColumnCount[COLUMN_LABEL_DATA];
+    for (size_t i = 0; i < m_nRows; i++) {
+        if (pOffsets[i] > pOffsets[i+1] || pOffsets[i+1] > nLabelBytes)
+            break;
+        mapPoints.emplace(std::string(pLabels + pOffsets[i], pOffsets[i+1] - pOffsets[i]), pValues[i]);
+    }
+    return mapPoints;
+}
+
+size_t SeriesFile::BlockCount() const
+{
+    if (!m_pIndex)
+        return 0;
+    return (m_nRows + m_nBlockRows - 1) / m_nBlockRows;
+}
+
+/**
+ * @brief SeriesFile::BlockRange: Minimum and maximum value (low and high for candles) of the rows in one block
+ */
+bool SeriesFile::BlockRange(size_t nBlock, double& dMin, double& dMax) const
+{
+    if (nBlock >= BlockCount())
+        return false;
+    dMin = m_pIndex[2*nBlock];
+    dMax = m_pIndex[2*nBlock + 1];
+    return true;
+}
+
+double SeriesFile::RowMin(size_t nRow) const
+{
+    return m_kind == Kind::CANDLE ? Column<double>(COLUMN_LOW)[nRow] : Column<double>(COLUMN_VALUE)[nRow];
+}
+
+double SeriesFile::RowMax(size_t nRow) const
+{
+    return m_kind == Kind::CANDLE ? Column<double>(COLUMN_HIGH)[nRow] : Column<double>(COLUMN_VALUE)[nRow];
+}
+
+/**
+ * @brief SeriesFile::RowRange: Minimum and maximum value of the rows in [nFirst, nLast).
+ * Whole blocks are answered from the block index, so only the partial blocks at either end are read.
+ */
+bool SeriesFile::RowRange(size_t nFirst, size_t nLast, double& dMin, double& dMax) const
+{
+    nLast = std::min<size_t>(nLast, m_nRows);
+    if (!IsOpen() || m_kind == Kind::PIE || nFirst >= nLast)
+        return false;
+
+    dMin = std::numeric_limits<double>::max();
+    dMax = std::numeric_limits<double>::lowest();
+    size_t nRow = nFirst;
+    while (nRow < nLast) {
+        if (m_pIndex && nRow % m_nBlockRows == 0 && nRow + m_nBlockRows <= nLast) {
+            size_t nBlock = nRow / m_nBlockRows;
+            dMin = std::min(dMin, m_pIndex[2*nBlock]);
+            dMax = std::max(dMax, m_pIndex[2*nBlock + 1]);
+            nRow += m_nBlockRows;
+            continue;
+        }
+        dMin = std::min(dMin, RowMin(nRow));
+        dMax = std::max(dMax, RowMax(nRow));
+        nRow++;
+    }
+    return true;
+}
+
+/**
+ * @brief SeriesFile::WriteColumns: Lay out and write a series file
+ * @param vIndex: Flat {min, max} pairs, one per block of nBlockRows rows, or empty for no index
+ */
+bool SeriesFile::WriteColumns(const QString& strPath, Kind kind, uint64_t nRows, uint32_t nBlockRows,
+                              const std::vector<ColumnSpec>& vColumns, const std::vector<double>& vIndex)
+{
+    QFile file(strPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    SeriesFileHeader header;
+    memcpy(header.magic, SERIESFILE_MAGIC, sizeof(SERIESFILE_MAGIC));
+    header.nVersion = VERSION;
+    header.nKind = static_cast<uint16_t>(kind);
+    header.nColumns = static_cast<uint32_t>(vColumns.size());
+    header.nBlockRows = vIndex.empty() ? 0 : nBlockRows;
+    header.nRows = nRows;
+
+    //Every column starts on an 8 byte boundary so that it can be read in place
+    std::vector<SeriesFileColumn> vTable;
+    uint64_t nPos = AlignUp(sizeof(SeriesFileHeader) + vColumns.size() * sizeof(SeriesFileColumn));
+    for (const ColumnSpec& spec : vColumns) {
+        SeriesFileColumn column;
+        column.nType = spec.nType;
+        column.nElementSize = spec.nElementSize;
+        column.nOffset = nPos;
+        vTable.emplace_back(column);
+        nPos = AlignUp(nPos + spec.nCount * spec.nElementSize);
+    }
+    header.nIndexOffset = vIndex.empty() ? 0 : nPos;
+
+    if (file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header)))
+        return false;
+    if (!vTable.empty() && file.write(reinterpret_cast<const char*>(vTable.data()), vTable.size() * sizeof(SeriesFileColumn))
+            != static_cast<qint64>(vTable.size() * sizeof(SeriesFileColumn)))
+        return false;
+    for (size_t i = 0; i < vColumns.size(); i++) {
+        if (!PadTo(file, vTable[i].nOffset) || !vColumns[i].write(file))
+            return false;
+    }
+    if (!vIndex.empty()) {
+        qint64 nIndexBytes = static_cast<qint64>(vIndex.size() * sizeof(double));
+        if (!PadTo(file, header.nIndexOffset) || file.write(reinterpret_cast<const char*>(vIndex.data()), nIndexBytes) != nIndexBytes)
+            return false;
+    }
+    return file.flush();
+}
+
+/**
+ * @brief SeriesFile::WriteSeries: Write a line series file
+ * @param nBlockRows: Rows summarized by each block index entry, 0 to leave out the index
+ */
+bool SeriesFile::WriteSeries(const QString& strPath, const std::map<uint32_t, double>& mapPoints, uint32_t nBlockRows)
+{
+    std::vector<double> vIndex;
+    uint64_t nRow = 0;
+    for (const auto& pair : mapPoints)
+        IncludeInIndex(vIndex, nRow++, nBlockRows, pair.second, pair.second);
+
+    std::vector<ColumnSpec> vColumns = {
+        {COLUMN_TIME, sizeof(uint32_t), mapPoints.size(), [&mapPoints](QFile& file) {
+            BufferedWriter writer(file);
+            for (const auto& pair : mapPoints)
+                writer.Put(pair.first);
+            return writer.Flush();
+        }},
+        {COLUMN_VALUE, sizeof(double), mapPoints.size(), [&mapPoints](QFile& file) {
+            BufferedWriter writer(file);
+            for (const auto& pair : mapPoints)
+                writer.Put(pair.second);
+            return writer.Flush();
+        }}
+    };
+    return WriteColumns(strPath, Kind::LINE, mapPoints.size(), nBlockRows, vColumns, vIndex);
+}
+
+/**
+ * @brief SeriesFile::WriteCandles: Write a candle file, the block index holds the lowest low and highest high of each block
+ * @param nBlockRows: Rows summarized by each block index entry, 0 to leave out the index
+ */
+bool SeriesFile::WriteCandles(const QString& strPath, const std::map<uint32_t, Candle>& mapCandles, uint32_t nBlockRows)
+{
+    std::vector<double> vIndex;
+    uint64_t nRow = 0;
+    for (const auto& pair : mapCandles)
+        IncludeInIndex(vIndex, nRow++, nBlockRows, pair.second.m_low, pair.second.m_high);
+
+    //One column per candle field
+    auto fieldColumn = [&mapCandles](uint32_t nType, double Candle::*pField) {
+        return ColumnSpec{nType, sizeof(double), mapCandles.size(), [&mapCandles, pField](QFile& file) {
+            BufferedWriter writer(file);
+            for (const auto& pair : mapCandles)
+                writer.Put(pair.second.*pField);
+            return writer.Flush();
+        }};
+    };
+    std::vector<ColumnSpec> vColumns = {
+        {COLUMN_TIME, sizeof(uint32_t), mapCandles.size(), [&mapCandles](QFile& file) {
+            BufferedWriter writer(file);
+            for (const auto& pair : mapCandles)
+                writer.Put(pair.first);
+            return writer.Flush();
+        }},
+        fieldColumn(COLUMN_OPEN, &Candle::m_open),
+        fieldColumn(COLUMN_HIGH, &Candle::m_high),
+        fieldColumn(COLUMN_LOW, &Candle::m_low),
+        fieldColumn(COLUMN_CLOSE, &Candle::m_close),
+        fieldColumn(COLUMN_VOLUME, &Candle::m_volume)
+    };
+    return WriteColumns(strPath, Kind::CANDLE, mapCandles.size(), nBlockRows, vColumns, vIndex);
+}
+
+/**
+ * @brief SeriesFile::WritePie: Write a pie file of labelled values
+ */
+bool SeriesFile::WritePie(const QString& strPath, const std::map<std::string, double>& mapPoints)
+{
+    std::vector<uint32_t> vOffsets;
+    vOffsets.reserve(mapPoints.size() + 1);
+    uint64_t nLabelBytes = 0;
+    vOffsets.emplace_back(0);
+    for (const auto& pair : mapPoints) {
+        nLabelBytes += pair.first.size();
+        if (nLabelBytes > std::numeric_limits<uint32_t>::max())
+            return false;
+        vOffsets.emplace_back(static_cast<uint32_t>(nLabelBytes));
+    }
+
+    std::vector<ColumnSpec> vColumns = {
+        {COLUMN_VALUE, sizeof(double), mapPoints.size(), [&mapPoints](QFile& file) {
+            BufferedWriter writer(file);
+            for (const auto& pair : mapPoints)
+                writer.Put(pair.second);
+            return writer.Flush();
+        }},
+        {COLUMN_LABEL_OFFSET, sizeof(uint32_t), vOffsets.size(), [&vOffsets](QFile& file) {
+            qint64 nBytes = static_cast<qint64>(vOffsets.size() * sizeof(uint32_t));
+            return file.write(reinterpret_cast<const char*>(vOffsets.data()), nBytes) == nBytes;
+        }},
+        {COLUMN_LABEL_DATA, 1, nLabelBytes, [&mapPoints](QFile& file) {
+            BufferedWriter writer(file);
+            for (const auto& pair : mapPoints)
+                writer.PutBytes(pair.first.data(), pair.first.size());
+            return writer.Flush();
+        }}
+    };
+    return WriteColumns(strPath, Kind::PIE, mapPoints.size(), 0, vColumns, std::vector<double>());
+}
+
+} //namespace
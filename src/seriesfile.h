@@ -0,0 +1,157 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIESFILE_H
+#define SERIESFILE_H
+
+#include "candlestickchart.h"
+#include "seriesview.h"
+
+#include <QFile>
+#include <QString>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace PssCharts {
+
+/*
+ * Binary columnar series file, all values little endian:
+ *
+ *  SeriesFileHeader                      magic "PSSF", version, kind, column count, rows, block index location
+ *  SeriesFileColumn[nColumns]            column type, element size and offset of each column
+ *  column data                           one tightly packed array per column, each starting on an 8 byte boundary
+ *  block index (optional)                {double min, double max} for every nBlockRows rows
+ *
+ * Line files hold TIME (uint32) and VALUE (double) columns. Candle files hold TIME, OPEN, HIGH, LOW, CLOSE and
+ * VOLUME. Pie files hold VALUE, LABEL_OFFSET (uint32, nRows+1 byte offsets) and LABEL_DATA (utf8 bytes).
+ */
+struct SeriesFileHeader {
+    char magic[4];
+    uint16_t nVersion;
+    uint16_t nKind;
+    uint32_t nColumns;
+    uint32_t nBlockRows; //! Rows summarized by each block index entry, 0 if there is no index
+    uint64_t nRows;
+    uint64_t nIndexOffset;
+};
+
+struct SeriesFileColumn {
+    uint32_t nType;
+    uint32_t nElementSize;
+    uint64_t nOffset;
+};
+
+/**
+ * @brief SeriesFile: Memory maps a series file so that charts can draw from it through a LineView or CandleView
+ * without parsing or copying. Only the pages that are actually read get loaded by the operating system.
+ * The views stay valid until the file is closed or destroyed. Files with a block index hand it to their views, so the
+ * charts take extents from it instead of reading every row.
+ */
+class SeriesFile : public ViewRangeIndex
+{
+public:
+    enum class Kind : uint16_t
+    {
+        NONE = 0,
+        LINE = 1,
+        CANDLE = 2,
+        PIE = 3
+    };
+
+    enum ColumnType : uint32_t
+    {
+        COLUMN_TIME = 1,
+        COLUMN_VALUE,
+        COLUMN_OPEN,
+        COLUMN_HIGH,
+        COLUMN_LOW,
+        COLUMN_CLOSE,
+        COLUMN_VOLUME,
+        COLUMN_LABEL_OFFSET,
+        COLUMN_LABEL_DATA,
+        COLUMN_TYPE_COUNT
+    };
+
+    static const uint16_t VERSION = 1;
+    static const uint32_t DEFAULT_BLOCK_ROWS = 4096;
+
+private:
+    QFile m_file;
+    uchar* m_pMap;
+    qint64 m_nMapSize;
+    QString m_strError;
+    Kind m_kind;
+    uint64_t m_nRows;
+    uint32_t m_nBlockRows;
+    const double* m_pIndex;
+    std::vector<const uchar*> m_vColumns; //! Start of each column in the mapping, indexed by ColumnType
+    std::vector<uint64_t> m_vColumnCount; //! Number of elements in each column
+
+    bool Fail(const QString& strError);
+    template <typename T>
+    const T* Column(ColumnType type) const { return reinterpret_cast<const T*>(m_vColumns[type]); }
+    double RowMin(size_t nRow) const;
+    double RowMax(size_t nRow) const;
+
+    struct ColumnSpec {
+        uint32_t nType;
+        uint32_t nElementSize;
+        uint64_t nCount;
+        std::function<bool(QFile&)> write;
+    };
+    static bool WriteColumns(const QString& strPath, Kind kind, uint64_t nRows, uint32_t nBlockRows,
+                             const std::vector<ColumnSpec>& vColumns, const std::vector<double>& vIndex);
+
+public:
+    SeriesFile();
+    ~SeriesFile() override;
+    SeriesFile(const SeriesFile&) = delete;
+    SeriesFile& operator=(const SeriesFile&) = delete;
+
+    bool Open(const QString& strPath);
+    void Close();
+    bool IsOpen() const { return m_pMap != nullptr; }
+    QString ErrorString() const { return m_strError; }
+
+    Kind FileKind() const { return m_kind; }
+    uint64_t Rows() const { return m_nRows; }
+    LineView Series() const;
+    CandleView Candles() const;
+    std::map<std::string, double> PieData() const;
+
+    size_t BlockRows() const override { return m_nBlockRows; }
+    size_t BlockCount() const;
+    bool BlockRange(size_t nBlock, double& dMin, double& dMax) const;
+    bool RowRange(size_t nFirst, size_t nLast, double& dMin, double& dMax) const override;
+
+    static bool WriteSeries(const QString& strPath, const std::map<uint32_t, double>& mapPoints, uint32_t nBlockRows = DEFAULT_BLOCK_ROWS);
+    static bool WriteCandles(const QString& strPath, const std::map<uint32_t, Candle>& mapCandles, uint32_t nBlockRows = DEFAULT_BLOCK_ROWS);
+    static bool WritePie(const QString& strPath, const std::map<std::string, double>& mapPoints);
+};
+
+} //namespace
+#endif // SERIESFILE_H
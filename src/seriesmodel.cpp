@@ -0,0 +1,230 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "seriesmodel.h"
+
+namespace PssCharts {
+
+SeriesModel::SeriesModel(QObject* parent) : QObject(parent)
+{
+    m_fExtentsValid = false;
+    m_pairXExtent = {0, 0};
+    m_pairYExtent = {0, 0};
+    m_fPointIndexValid = false;
+    m_fVolumeIndexValid = false;
+}
+
+void SeriesModel::InvalidateDerived()
+{
+    m_fExtentsValid = false;
+    m_mapCandles.clear();
+    m_fPointIndexValid = false;
+    m_indexPoints.Clear();
+}
+
+/**
+ * @brief SeriesModel::AddToCandles: Fold one point into a candle series, the same way
+ * CandlestickChart::ConvertLineToCandlestickData does: a candle starts at a point and takes every following
+ * point that is no more than nPeriod after its start.
+ */
+void SeriesModel::AddToCandles(std::map<uint32_t, Candle>& mapCandles, uint32_t nPeriod, const uint32_t& x, const double& y)
+{
+    if (mapCandles.empty() || x - mapCandles.rbegin()->first > nPeriod) {
+        mapCandles.emplace_hint(mapCandles.end(), x, Candle(y, y, y, y));
+        return;
+    }
+    Candle& candle = mapCandles.rbegin()->second;
+    candle.m_low = std::min(y, candle.m_low);
+    candle.m_high = std::max(y, candle.m_high);
+    candle.m_close = y;
+}
+
+/**
+ * @brief SeriesModel::Extents: The minimum and maximum x and y of the points
+ * @return false if there are no points
+ */
+bool SeriesModel::Extents(std::pair<double, double>& pairX, std::pair<double, double>& pairY) const
+{
+    if (m_mapPoints.empty())
+        return false;
+
+    if (!m_fExtentsValid) {
+        m_pairXExtent = {m_mapPoints.begin()->first, m_mapPoints.rbegin()->first};
+        m_pairYExtent = {m_mapPoints.begin()->second, m_mapPoints.begin()->second};
+        for (const auto& pair : m_mapPoints) {
+            m_pairYExtent.first = std::min(m_pairYExtent.first, pair.second);
+            m_pairYExtent.second = std::max(m_pairYExtent.second, pair.second);
+        }
+        m_fExtentsValid = true;
+    }
+    pairX = m_pairXExtent;
+    pairY = m_pairYExtent;
+    return true;
+}
+
+/**
+ * @brief SeriesModel::Candles: The points grouped into candles of nPeriod seconds. Built on first use for a period and then
+ * kept up to date as points are appended, so every chart showing the same period shares one set of candles.
+ * Volume is not folded into the candles.
+ */
+const std::map<uint32_t, Candle>& SeriesModel::Candles(uint32_t nPeriod) const
+{
+    auto it = m_mapCandles.find(nPeriod);
+    if (it != m_mapCandles.end())
+        return it->second;
+
+    std::map<uint32_t, Candle>& mapCandles = m_mapCandles[nPeriod];
+    for (const auto& pair : m_mapPoints)
+        AddToCandles(mapCandles, nPeriod, pair.first, pair.second);
+    return mapCandles;
+}
+
+/**
+ * @brief SeriesModel::PointIndex: Range sums and extremes of the points. Built on first use and then extended as points are
+ * appended, so range tooltips, autoscaling and aggregated bars all read one shared index.
+ */
+const SeriesIndex& SeriesModel::PointIndex() const
+{
+    if (!m_fPointIndexValid) {
+        m_indexPoints.Assign(m_mapPoints);
+        m_fPointIndexValid = true;
+    }
+    return m_indexPoints;
+}
+
+/**
+ * @brief SeriesModel::VolumeIndex: Range sums and extremes of the volume, for example the volume traded in a window
+ */
+const SeriesIndex& SeriesModel::VolumeIndex() const
+{
+    if (!m_fVolumeIndexValid) {
+        m_indexVolume.Assign(m_mapVolume);
+        m_fVolumeIndexValid = true;
+    }
+    return m_indexVolume;
+}
+
+void SeriesModel::SetPoints(const std::map<uint32_t, double>& mapPoints)
+{
+    SetPoints(std::map<uint32_t, double>(mapPoints));
+}
+
+void SeriesModel::SetPoints(std::map<uint32_t, double>&& mapPoints)
+{
+    m_mapPoints = std::move(mapPoints);
+    InvalidateDerived();
+    emit dataReset();
+}
+
+/**
+ * @brief SeriesModel::AppendPoints: Add a batch of points. A sorted batch that is newer than the last point
+ * extends the derived products in place and is announced with pointsAppended().
+ */
+void SeriesModel::AppendPoints(const std::pair<uint32_t, double>* pPoints, size_t nCount)
+{
+    if (nCount == 0)
+        return;
+
+    size_t nSizeBefore = m_mapPoints.size();
+    bool fTail = Chart::MergeIntoMap(m_mapPoints, pPoints, nCount);
+    if (!fTail || m_mapPoints.size() != nSizeBefore + nCount) {
+        InvalidateDerived();
+        emit dataReset();
+        return;
+    }
+
+    for (size_t i = 0; i < nCount; i++) {
+        const std::pair<uint32_t, double>& pair = pPoints[i];
+        if (m_fExtentsValid) {
+            m_pairXExtent.first = std::min<double>(m_pairXExtent.first, pair.first);
+            m_pairXExtent.second = std::max<double>(m_pairXExtent.second, pair.first);
+            m_pairYExtent.first = std::min(m_pairYExtent.first, pair.second);
+            m_pairYExtent.second = std::max(m_pairYExtent.second, pair.second);
+        }
+        for (auto& period : m_mapCandles)
+            AddToCandles(period.second, period.first, pair.first, pair.second);
+        if (m_fPointIndexValid)
+            m_indexPoints.Append(pair.first, pair.second);
+    }
+    emit pointsAppended(pPoints[0].first, pPoints[nCount - 1].first);
+}
+
+void SeriesModel::AppendPoints(const std::vector<std::pair<uint32_t, double>>& vPoints)
+{
+    if (vPoints.empty())
+        return;
+    AppendPoints(vPoints.data(), vPoints.size());
+}
+
+/**
+ * @brief SeriesModel::RemovePoints: Remove every point with nFirstX <= x <= nLastX
+ */
+void SeriesModel::RemovePoints(uint32_t nFirstX, uint32_t nLastX)
+{
+    if (nFirstX > nLastX)
+        return;
+    auto itBegin = m_mapPoints.lower_bound(nFirstX);
+    auto itEnd = m_mapPoints.upper_bound(nLastX);
+    if (itBegin == itEnd)
+        return;
+    m_mapPoints.erase(itBegin, itEnd);
+    InvalidateDerived();
+    emit pointsRemoved(nFirstX, nLastX);
+}
+
+void SeriesModel::SetVolume(std::map<uint32_t, double>&& mapVolume)
+{
+    m_mapVolume = std::move(mapVolume);
+    m_fVolumeIndexValid = false;
+    m_indexVolume.Clear();
+    emit volumeChanged();
+}
+
+void SeriesModel::AppendVolume(const std::pair<uint32_t, double>* pPoints, size_t nCount)
+{
+    if (nCount == 0)
+        return;
+    size_t nSizeBefore = m_mapVolume.size();
+    bool fTail = Chart::MergeIntoMap(m_mapVolume, pPoints, nCount);
+    if (!fTail || m_mapVolume.size() != nSizeBefore + nCount) {
+        m_fVolumeIndexValid = false;
+        m_indexVolume.Clear();
+    } else if (m_fVolumeIndexValid) {
+        for (size_t i = 0; i < nCount; i++)
+            m_indexVolume.Append(pPoints[i].first, pPoints[i].second);
+    }
+    emit volumeChanged();
+}
+
+void SeriesModel::Clear()
+{
+    m_mapPoints.clear();
+    m_mapVolume.clear();
+    m_fVolumeIndexValid = false;
+    m_indexVolume.Clear();
+    InvalidateDerived();
+    emit dataReset();
+}
+
+} //namespace
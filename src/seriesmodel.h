@@ -0,0 +1,97 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIESMODEL_H
+#define SERIESMODEL_H
+
+#include "candlestickchart.h"
+#include "rangeindex.h"
+
+#include <QObject>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace PssCharts {
+
+/**
+ * @brief SeriesModel: One instrument's price and volume history shared by several charts.
+ * Charts hold the model through a std::shared_ptr and observe its signals, so the data and the products derived
+ * from it (extents and candles for each candle period) are stored and computed once no matter how many charts
+ * show it. Each chart keeps only its own screen caches.
+ *
+ * Appends that are sorted and newer than the last point emit pointsAppended() and update the derived products
+ * in place. Any other change emits pointsRemoved() or dataReset() and the derived products are rebuilt on next use.
+ */
+class SeriesModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    std::map<uint32_t, double> m_mapPoints;
+    std::map<uint32_t, double> m_mapVolume;
+
+    //Derived products, built on first use
+    mutable bool m_fExtentsValid;
+    mutable std::pair<double, double> m_pairXExtent;
+    mutable std::pair<double, double> m_pairYExtent;
+    mutable std::map<uint32_t, std::map<uint32_t, Candle>> m_mapCandles; //! Candles keyed by candle period
+    mutable bool m_fPointIndexValid;
+    mutable SeriesIndex m_indexPoints;
+    mutable bool m_fVolumeIndexValid;
+    mutable SeriesIndex m_indexVolume;
+
+    void InvalidateDerived();
+    static void AddToCandles(std::map<uint32_t, Candle>& mapCandles, uint32_t nPeriod, const uint32_t& x, const double& y);
+
+signals:
+    void pointsAppended(uint32_t nFirstX, uint32_t nLastX);
+    void pointsRemoved(uint32_t nFirstX, uint32_t nLastX);
+    void volumeChanged();
+    void dataReset();
+
+public:
+    SeriesModel(QObject* parent = nullptr);
+
+    const std::map<uint32_t, double>& Points() const { return m_mapPoints; }
+    const std::map<uint32_t, double>& Volume() const { return m_mapVolume; }
+    bool Empty() const { return m_mapPoints.empty(); }
+    bool Extents(std::pair<double, double>& pairX, std::pair<double, double>& pairY) const;
+    const std::map<uint32_t, Candle>& Candles(uint32_t nPeriod) const;
+    const SeriesIndex& PointIndex() const;
+    const SeriesIndex& VolumeIndex() const;
+
+    void SetPoints(const std::map<uint32_t, double>& mapPoints);
+    void SetPoints(std::map<uint32_t, double>&& mapPoints);
+    void AppendPoints(const std::pair<uint32_t, double>* pPoints, size_t nCount);
+    void AppendPoints(const std::vector<std::pair<uint32_t, double>>& vPoints);
+    void RemovePoints(uint32_t nFirstX, uint32_t nLastX);
+    void SetVolume(std::map<uint32_t, double>&& mapVolume);
+    void AppendVolume(const std::pair<uint32_t, double>* pPoints, size_t nCount);
+    void Clear();
+};
+
+} //namespace
+#endif // SERIESMODEL_H
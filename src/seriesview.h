@@ -0,0 +1,213 @@
+/*
+MIT License
+
+Copyright (c) 2020 Paddington Software Services
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef SERIESVIEW_H
+#define SERIESVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+namespace PssCharts {
+
+/**
+ * @brief StridedColumn: Read-only access to a column of values that live in memory owned by the caller.
+ * nStride is the distance in bytes between two consecutive values, so a column can be read straight out
+ * of an array of structs. A stride of 0 means the values are tightly packed.
+ */
+template <typename T>
+class StridedColumn
+{
+    const char* m_pData;
+    size_t m_nStride;
+
+public:
+    StridedColumn() : m_pData(nullptr), m_nStride(sizeof(T)) {}
+    StridedColumn(const T* pData, size_t nStride = 0) : m_pData(reinterpret_cast<const char*>(pData)), m_nStride(nStride ? nStride : sizeof(T)) {}
+
+    bool IsNull() const { return m_pData == nullptr; }
+    T operator[](size_t i) const { return *reinterpret_cast<const T*>(m_pData + i*m_nStride); }
+};
+
+/**
+ * @brief ViewIterator: Random access iterator over a view. Dereferencing returns the element by value,
+ * so it can be used with the standard algorithms and std::reverse_iterator but not with operator->.
+ */
+template <typename View>
+class ViewIterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename View::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef value_type reference;
+
+private:
+    const View* m_pView;
+    size_t m_nIndex;
+
+public:
+    ViewIterator() : m_pView(nullptr), m_nIndex(0) {}
+    ViewIterator(const View* pView, size_t nIndex) : m_pView(pView), m_nIndex(nIndex) {}
+
+    size_t Index() const { return m_nIndex; }
+
+    reference operator*() const { return m_pView->At(m_nIndex); }
+    reference operator[](difference_type n) const { return m_pView->At(m_nIndex + n); }
+    ViewIterator& operator++() { ++m_nIndex; return *this; }
+    ViewIterator& operator--() { --m_nIndex; return *this; }
+    ViewIterator operator++(int) { ViewIterator it = *this; ++m_nIndex; return it; }
+    ViewIterator operator--(int) { ViewIterator it = *this; --m_nIndex; return it; }
+    ViewIterator& operator+=(difference_type n) { m_nIndex += n; return *this; }
+    ViewIterator& operator-=(difference_type n) { m_nIndex -= n; return *this; }
+    ViewIterator operator+(difference_type n) const { return ViewIterator(m_pView, m_nIndex + n); }
+    ViewIterator operator-(difference_type n) const { return ViewIterator(m_pView, m_nIndex - n); }
+    difference_type operator-(const ViewIterator& other) const { return static_cast<difference_type>(m_nIndex) - static_cast<difference_type>(other.m_nIndex); }
+    bool operator==(const ViewIterator& other) const { return m_nIndex == other.m_nIndex; }
+    bool operator!=(const ViewIterator& other) const { return m_nIndex != other.m_nIndex; }
+    bool operator<(const ViewIterator& other) const { return m_nIndex < other.m_nIndex; }
+    bool operator>(const ViewIterator& other) const { return m_nIndex > other.m_nIndex; }
+    bool operator<=(const ViewIterator& other) const { return m_nIndex <= other.m_nIndex; }
+    bool operator>=(const ViewIterator& other) const { return m_nIndex >= other.m_nIndex; }
+};
+
+/**
+ * @brief ViewRangeIndex: Minimum and maximum value of any row range of a view, answered by whoever owns the memory behind
+ * it. A memory mapped file keeps one (min, max) pair per block of rows, so a chart can find the extents of a range without
+ * reading the rows, which would page them in.
+ */
+class ViewRangeIndex
+{
+public:
+    virtual ~ViewRangeIndex() {}
+
+    //! Rows summarized by each block, ranges that start and end on a block boundary are the cheapest to query
+    virtual size_t BlockRows() const = 0;
+    //! Minimum and maximum value of the rows in [nFirst, nLast), false if the range is empty
+    virtual bool RowRange(size_t nFirst, size_t nLast, double& dMin, double& dMax) const = 0;
+};
+
+/**
+ * @brief LineView: Non-owning view of (x, y) points held in caller owned arrays.
+ * The x values must be strictly increasing, the same ordering a std::map series has.
+ * The chart only reads through the view, the caller keeps the memory alive for as long as the view is set.
+ */
+class LineView
+{
+    StridedColumn<uint32_t> m_columnX;
+    StridedColumn<double> m_columnY;
+    size_t m_nSize;
+    const ViewRangeIndex* m_pRangeIndex;
+
+public:
+    typedef std::pair<uint32_t, double> value_type;
+    typedef ViewIterator<LineView> const_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    LineView() : m_nSize(0), m_pRangeIndex(nullptr) {}
+    LineView(const uint32_t* pX, const double* pY, size_t nSize, size_t nXStride = 0, size_t nYStride = 0)
+        : m_columnX(pX, nXStride), m_columnY(pY, nYStride), m_nSize(nSize), m_pRangeIndex(nullptr) {}
+
+    size_t Size() const { return m_nSize; }
+    bool Empty() const { return m_nSize == 0; }
+    uint32_t X(size_t i) const { return m_columnX[i]; }
+    double Y(size_t i) const { return m_columnY[i]; }
+    value_type At(size_t i) const { return value_type(m_columnX[i], m_columnY[i]); }
+
+    //! The index must outlive the view, the same as the memory behind it
+    void SetRangeIndex(const ViewRangeIndex* pIndex) { m_pRangeIndex = pIndex; }
+    const ViewRangeIndex* RangeIndex() const { return m_pRangeIndex; }
+
+    //! Minimum and maximum y of the points in [nFirst, nLast), read from the range index if there is one
+    bool MinMaxAt(size_t nFirst, size_t nLast, double& dMin, double& dMax) const
+    {
+        if (nLast > m_nSize)
+            nLast = m_nSize;
+        if (nFirst >= nLast)
+            return false;
+        if (m_pRangeIndex)
+            return m_pRangeIndex->RowRange(nFirst, nLast, dMin, dMax);
+        dMin = dMax = m_columnY[nFirst];
+        for (size_t i = nFirst + 1; i < nLast; i++) {
+            double dY = m_columnY[i];
+            if (dY < dMin)
+                dMin = dY;
+            if (dY > dMax)
+                dMax = dY;
+        }
+        return true;
+    }
+
+    //! Index of the first point with an x value that is not less than x
+    size_t LowerBound(uint32_t x) const
+    {
+        size_t nLow = 0;
+        size_t nHigh = m_nSize;
+        while (nLow < nHigh) {
+            size_t nMid = nLow + (nHigh - nLow) / 2;
+            if (m_columnX[nMid] < x)
+                nLow = nMid + 1;
+            else
+                nHigh = nMid;
+        }
+        return nLow;
+    }
+
+    //! Index of the first point with an x value that is greater than x
+    size_t UpperBound(uint32_t x) const
+    {
+        size_t nLow = 0;
+        size_t nHigh = m_nSize;
+        while (nLow < nHigh) {
+            size_t nMid = nLow + (nHigh - nLow) / 2;
+            if (m_columnX[nMid] <= x)
+                nLow = nMid + 1;
+            else
+                nHigh = nMid;
+        }
+        return nLow;
+    }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, m_nSize); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+};
+
+/**
+ * @brief VisitUntil: Call fn for each element in [itBegin, itEnd) until fn returns false
+ */
+template <typename Iterator, typename Fn>
+void VisitUntil(Iterator itBegin, Iterator itEnd, Fn fn)
+{
+    for (; itBegin != itEnd; ++itBegin) {
+        if (!fn(*itBegin))
+            break;
+    }
+}
+
+} //namespace
+#endif // SERIESVIEW_H